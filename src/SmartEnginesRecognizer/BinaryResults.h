@@ -0,0 +1,619 @@
+#ifndef SMARTENGINES_RECOGNIZER_BINARY_RESULTS_H
+#define SMARTENGINES_RECOGNIZER_BINARY_RESULTS_H
+
+#include "DataDirectory.h"
+#include "MappedFile.h"
+#include "ResultReporter.h"
+#include "Stopwatch.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <set>
+#include <string>
+#include <vector>
+
+// Binary output: all results of a data pack go to "<pack>.results", a
+// header followed by fixed-size records, and "<pack>.results.pool", which
+// holds the strings and match lists the records point to. Every number sits
+// at a fixed offset in its record, so a reader maps both files and reads
+// fields in place. The pool is written before the records that refer to it,
+// so a crash can only leave a partial record, or records pointing past the
+// pool, at the end; readers stop there and writers cut them off before
+// appending. Numbers are stored in the byte order of the writing machine;
+// the header lets a reader detect a mismatch, and a file with another
+// header is set aside rather than appended to or overwritten. Records are only ever
+// appended, so the last one for an image wins.
+
+const char binary_results_magic[8] = { 'S', 'E', 'R', 'E', 'S', 'U', 'L', 'T' };
+const uint32_t binary_results_version = 1;
+const uint32_t binary_results_byte_order = 0x01020304;
+
+// Indices into passport_fields, for readers
+enum BinaryField
+{
+	binary_authority,
+	binary_authority_code,
+	binary_birthdate,
+	binary_birthplace,
+	binary_gender,
+	binary_issue_date,
+	binary_mrz_line1,
+	binary_mrz_line2,
+	binary_name,
+	binary_number,
+	binary_patronymic,
+	binary_series,
+	binary_surname,
+	binary_field_count
+};
+
+static_assert(binary_field_count == passport_field_count &&
+	IsPassportField<binary_authority>("authority") && IsPassportField<binary_authority_code>("authority_code") &&
+	IsPassportField<binary_birthdate>("birthdate") && IsPassportField<binary_birthplace>("birthplace") &&
+	IsPassportField<binary_gender>("gender") && IsPassportField<binary_issue_date>("issue_date") &&
+	IsPassportField<binary_mrz_line1>("mrz_line1") && IsPassportField<binary_mrz_line2>("mrz_line2") &&
+	IsPassportField<binary_name>("name") && IsPassportField<binary_number>("number") &&
+	IsPassportField<binary_patronymic>("patronymic") && IsPassportField<binary_series>("series") &&
+	IsPassportField<binary_surname>("surname"),
+	"BinaryField must follow passport_fields");
+
+enum BinaryResultFlags
+{
+	binary_snapshot_rejected = 1,
+	binary_has_data = 2,
+	binary_enough_data = 4
+};
+
+struct BinaryResultsHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint32_t record_size;
+	uint32_t field_count;
+	uint32_t reserved[2];
+};
+
+// Bytes [offset, offset + length) of the pool
+struct BinaryString
+{
+	uint64_t offset;
+	uint32_t length;
+	uint32_t reserved;
+};
+
+struct BinaryPhase
+{
+	double wall_ms;
+	double cpu_ms;
+};
+
+struct BinaryMatch
+{
+	double score;
+	BinaryString type;
+};
+
+struct BinaryResultRecord
+{
+	BinaryString image_name;
+	BinaryString image_path;
+	double time;
+	BinaryPhase initialize_session;
+	BinaryPhase process_image;
+	BinaryPhase terminate_session;
+	BinaryPhase build_json;
+	BinaryPhase write_file;
+	uint32_t flags;
+	uint32_t accepted;          // bit (1 << field) is set if the field was accepted
+	uint32_t match_count;
+	uint32_t reserved;
+	uint64_t matches_offset;    // BinaryMatch[match_count] in the pool, 8-byte aligned
+	BinaryString fields[binary_field_count];
+};
+
+static_assert(sizeof(BinaryResultsHeader) == 32, "BinaryResultsHeader must not be padded");
+static_assert(sizeof(BinaryString) == 16 && sizeof(BinaryMatch) == 24, "BinaryString and BinaryMatch must not be padded");
+static_assert(sizeof(BinaryResultRecord) == 352, "BinaryResultRecord must not be padded");
+
+inline BinaryResultsHeader MakeBinaryResultsHeader()
+{
+	BinaryResultsHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, binary_results_magic, sizeof(header.magic));
+	header.version = binary_results_version;
+	header.byte_order = binary_results_byte_order;
+	header.record_size = sizeof(BinaryResultRecord);
+	header.field_count = binary_field_count;
+	return header;
+}
+
+inline bool IsBinaryResultsHeader(const char *data, size_t size)
+{
+	BinaryResultsHeader expected = MakeBinaryResultsHeader();
+	return size >= sizeof(expected) && memcmp(data, &expected, sizeof(expected)) == 0;
+}
+
+inline std::string BinaryResultsPath(const std::string &result_dir_path, const std::string &relative_path, const std::string &file_suffix)
+{
+	return result_dir_path + "/" + PackOf(relative_path) + file_suffix + ".results";
+}
+
+inline std::string BinaryResultsPoolPath(const std::string &results_path)
+{
+	return results_path + ".pool";
+}
+
+inline void SetBinaryPhase(BinaryPhase &binary, const PhaseTime &phase)
+{
+	binary.wall_ms = phase.wall_ms;
+	binary.cpu_ms = phase.cpu_ms;
+}
+
+inline bool PrepareBinaryResultsAppend(const std::string &results_path);
+
+// Records and pool bytes of one pack, collected in memory by Add and written
+// out in one go by Flush
+class BinaryResultsPack
+{
+	std::string path;
+	std::ofstream records;
+	std::ofstream pool;
+	unsigned long long pool_size;
+
+	std::string record_buffer;
+	std::string pool_buffer;
+	std::vector<std::string> buffered_entries;
+
+	BinaryString AddString(const std::string &value)
+	{
+		BinaryString string;
+		string.offset = pool_size + pool_buffer.size();
+		string.length = static_cast<uint32_t>(value.size());
+		string.reserved = 0;
+		pool_buffer += value;
+		return string;
+	}
+
+	template <typename Field>
+	void AddField(BinaryResultRecord &record, size_t index, const Field &field)
+	{
+		record.fields[index] = AddString(PassportFieldText<Field>::Get(field));
+		if (field.is_accepted)
+		{
+			record.accepted |= 1u << index;
+		}
+	}
+
+public:
+	BinaryResultsPack(const std::string &results_path, bool append)
+		: path(results_path)
+	{
+		append = append && PrepareBinaryResultsAppend(path);
+
+		std::ios::openmode mode = std::ios::binary | (append ? std::ios::app : std::ios::trunc);
+		pool_size = append ? FileSize(BinaryResultsPoolPath(path)) : 0;
+		records.open(path, mode);
+		pool.open(BinaryResultsPoolPath(path), mode);
+
+		if (!append)
+		{
+			BinaryResultsHeader header = MakeBinaryResultsHeader();
+			record_buffer.append(reinterpret_cast<const char *>(&header), sizeof(header));
+		}
+	}
+
+	const std::string &Path() const
+	{
+		return path;
+	}
+
+	size_t BufferedBytes() const
+	{
+		return record_buffer.size() + pool_buffer.size();
+	}
+
+	void Add(const std::string &relative_path, ImageResult &result)
+	{
+		Stopwatch stopwatch;
+
+		BinaryResultRecord record;
+		memset(&record, 0, sizeof(record));
+
+		record.image_name = AddString(ImageNameOf(relative_path));
+		record.image_path = AddString(result.image_path);
+		record.time = result.time;
+
+		record.flags = (result.snapshot_rejected ? binary_snapshot_rejected : 0) |
+			(result.has_data ? binary_has_data : 0) |
+			(result.enough_data ? binary_enough_data : 0);
+
+		if (result.has_data)
+		{
+			ForEachPassportField([&](auto index, const auto &info)
+			{
+				AddField(record, index, info.Of(result.data));
+			});
+		}
+
+		std::vector<BinaryMatch> matches(result.matches.size());
+		for (size_t i = 0; i < matches.size(); ++i)
+		{
+			matches[i].score = result.matches[i].score;
+			matches[i].type = AddString(result.matches[i].type);
+		}
+
+		pool_buffer.append(static_cast<size_t>((8 - (pool_size + pool_buffer.size()) % 8) % 8), '\0');
+		record.match_count = static_cast<uint32_t>(matches.size());
+		record.matches_offset = pool_size + pool_buffer.size();
+		if (!matches.empty())
+		{
+			pool_buffer.append(reinterpret_cast<const char *>(matches.data()), matches.size() * sizeof(BinaryMatch));
+		}
+
+		result.timing.build_json = stopwatch.Stop();
+		SetBinaryPhase(record.initialize_session, result.timing.initialize_session);
+		SetBinaryPhase(record.process_image, result.timing.process_image);
+		SetBinaryPhase(record.terminate_session, result.timing.terminate_session);
+		SetBinaryPhase(record.build_json, result.timing.build_json);
+		SetBinaryPhase(record.write_file, result.timing.write_file);
+
+		record_buffer.append(reinterpret_cast<const char *>(&record), sizeof(record));
+		buffered_entries.push_back(relative_path);
+	}
+
+	// Calls complete(entry) for every record that is now in place
+	template <typename Complete>
+	bool Flush(Complete complete)
+	{
+		if (buffered_entries.empty() && record_buffer.empty())
+		{
+			return true;
+		}
+
+		pool.write(pool_buffer.data(), pool_buffer.size());
+		pool.flush();
+		if (!pool.fail())
+		{
+			records.write(record_buffer.data(), record_buffer.size());
+			records.flush();
+		}
+
+		bool written = !pool.fail() && !records.fail();
+		if (written)
+		{
+			for (const std::string &entry : buffered_entries)
+			{
+				complete(entry);
+			}
+		}
+
+		pool_size += pool_buffer.size();
+		record_buffer.clear();
+		pool_buffer.clear();
+		buffered_entries.clear();
+		return written;
+	}
+};
+
+// Batches the records of every pack up to batch_bytes before writing
+class BinaryResultsWriter
+{
+	std::string result_dir_path;
+	std::string file_suffix;
+	bool append;
+	size_t batch_bytes;
+	std::map<std::string, std::unique_ptr<BinaryResultsPack>> packs;
+
+public:
+	BinaryResultsWriter(const std::string &result_dir, const std::string &suffix, bool append_to_existing, size_t batch_size = 1 << 20)
+		: result_dir_path(result_dir), file_suffix(suffix), append(append_to_existing), batch_bytes(batch_size)
+	{
+	}
+
+	// complete(entry) is called once a record is written out, failed(path)
+	// if writing a pack file fails
+	template <typename Complete, typename Failed>
+	void Write(const std::string &relative_path, ImageResult &result, Complete complete, Failed failed)
+	{
+		std::unique_ptr<BinaryResultsPack> &pack = packs[PackOf(relative_path)];
+		if (!pack)
+		{
+			pack.reset(new BinaryResultsPack(BinaryResultsPath(result_dir_path, relative_path, file_suffix), append));
+		}
+
+		pack->Add(relative_path, result);
+		if (pack->BufferedBytes() >= batch_bytes && !pack->Flush(complete))
+		{
+			failed(pack->Path());
+		}
+	}
+
+	template <typename Complete, typename Failed>
+	void Flush(Complete complete, Failed failed)
+	{
+		for (auto &pack : packs)
+		{
+			if (!pack.second->Flush(complete))
+			{
+				failed(pack.second->Path());
+			}
+		}
+	}
+};
+
+// Pointer and length of a string in the pool; not null-terminated
+struct BinaryStringView
+{
+	const char *data;
+	size_t length;
+
+	std::string ToString() const
+	{
+		return std::string(data, length);
+	}
+
+	bool operator==(const char *other) const
+	{
+		return strlen(other) == length && memcmp(data, other, length) == 0;
+	}
+};
+
+// Read-only view of a "<pack>.results" file and its pool, mapped into
+// memory. Open checks that every string and match list is inside the pool,
+// after which all accessors read the mapping in place.
+class BinaryResultsFile
+{
+	MappedFile records;
+	MappedFile pool;
+	size_t count;
+
+	bool InPool(uint64_t offset, uint64_t length) const
+	{
+		return offset <= pool.Size() && length <= pool.Size() - offset;
+	}
+
+	bool InPool(const BinaryString &string) const
+	{
+		return InPool(string.offset, string.length);
+	}
+
+	bool IsValid(const BinaryResultRecord &record) const
+	{
+		if (!InPool(record.image_name) || !InPool(record.image_path))
+		{
+			return false;
+		}
+		for (const BinaryString &field : record.fields)
+		{
+			if (!InPool(field))
+			{
+				return false;
+			}
+		}
+		if (record.matches_offset % 8 != 0 || !InPool(record.matches_offset, static_cast<uint64_t>(record.match_count) * sizeof(BinaryMatch)))
+		{
+			return false;
+		}
+		for (uint32_t i = 0; i < record.match_count; ++i)
+		{
+			if (!InPool(Matches(record)[i].type))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+public:
+	BinaryResultsFile()
+		: count(0)
+	{
+	}
+
+	// Fails on a missing file or an unknown layout. The records end at a
+	// partial record or at the first one pointing outside of the pool, as
+	// left behind by a crash.
+	bool Open(const std::string &results_path)
+	{
+		count = 0;
+		if (!records.Open(results_path) || !pool.Open(BinaryResultsPoolPath(results_path)) ||
+			!IsBinaryResultsHeader(records.Data(), records.Size()))
+		{
+			return false;
+		}
+
+		size_t complete = (records.Size() - sizeof(BinaryResultsHeader)) / sizeof(BinaryResultRecord);
+		while (count < complete && IsValid((*this)[count]))
+		{
+			++count;
+		}
+		return true;
+	}
+
+	size_t Size() const
+	{
+		return count;
+	}
+
+	const BinaryResultRecord &operator[](size_t index) const
+	{
+		return reinterpret_cast<const BinaryResultRecord *>(records.Data() + sizeof(BinaryResultsHeader))[index];
+	}
+
+	BinaryStringView String(const BinaryString &string) const
+	{
+		BinaryStringView view;
+		view.data = pool.Data() + string.offset;
+		view.length = string.length;
+		return view;
+	}
+
+	BinaryStringView Field(const BinaryResultRecord &record, BinaryField field) const
+	{
+		return String(record.fields[field]);
+	}
+
+	static bool IsAccepted(const BinaryResultRecord &record, BinaryField field)
+	{
+		return (record.accepted & (1u << field)) != 0;
+	}
+
+	const BinaryMatch *Matches(const BinaryResultRecord &record) const
+	{
+		return reinterpret_cast<const BinaryMatch *>(pool.Data() + record.matches_offset);
+	}
+
+	// A copy of the whole pool
+	std::string Pool() const
+	{
+		return pool.Size() > 0 ? std::string(pool.Data(), pool.Size()) : std::string();
+	}
+};
+
+// Cuts an existing "<pack>.results" back to the records BinaryResultsFile
+// reads from it, so that appended records follow the last valid one.
+// Returns false if there is no file of the current layout to append to.
+inline bool RepairBinaryResults(const std::string &results_path)
+{
+	unsigned long long valid_size;
+	{
+		BinaryResultsFile existing;
+		if (!existing.Open(results_path))
+		{
+			return false;
+		}
+		valid_size = sizeof(BinaryResultsHeader) + static_cast<unsigned long long>(existing.Size()) * sizeof(BinaryResultRecord);
+	}
+
+	return FileSize(results_path) == valid_size || TruncateFile(results_path, valid_size);
+}
+
+// Readies a "<pack>.results" for appending. A file of another layout is
+// never overwritten: it is renamed to "<pack>.results.invalid", with its
+// pool, and throws if that fails. Returns false if the files are to be
+// started anew.
+inline bool PrepareBinaryResultsAppend(const std::string &results_path)
+{
+	if (FileSize(results_path) == 0)
+	{
+		return false;
+	}
+	if (RepairBinaryResults(results_path))
+	{
+		return true;
+	}
+
+	if (!ReplaceFile(results_path, results_path + ".invalid"))
+	{
+		throw std::runtime_error("Cannot set aside " + results_path);
+	}
+	std::string pool_path = BinaryResultsPoolPath(results_path);
+	ReplaceFile(pool_path, pool_path + ".invalid");
+	return false;
+}
+
+// Appends the records of "<pack><from>.results" for each of from_suffixes to
+// "<pack><to_suffix>.results" in the same directory, with pool offsets
+// shifted accordingly. Target files are restarted unless append is set.
+// Like a pack writer, every source goes in pool first, records second, both
+// flushed. Returns the sources that could not be read or written out; they
+// are never removed, and nothing more is appended to a target that failed.
+inline std::set<std::string> MergeBinaryResults(const std::string &result_dir_path, const std::vector<std::string> &from_suffixes, const std::string &to_suffix, bool append, bool remove_sources)
+{
+	std::set<std::string> unread_sources;
+	std::map<std::string, std::vector<std::string>> sources = FindPackFiles(result_dir_path, from_suffixes, ".results");
+
+	for (auto &pack : sources)
+	{
+		std::string target_path = result_dir_path + "/" + pack.first + to_suffix + ".results";
+		bool append_to_target = false;
+		try
+		{
+			append_to_target = append && PrepareBinaryResultsAppend(target_path);
+		}
+		catch (...) {
+			unread_sources.insert(pack.second.begin(), pack.second.end());
+			continue;
+		}
+
+		std::ios::openmode mode = std::ios::binary | (append_to_target ? std::ios::app : std::ios::trunc);
+		unsigned long long pool_size = append_to_target ? FileSize(BinaryResultsPoolPath(target_path)) : 0;
+
+		std::ofstream records(target_path, mode);
+		std::ofstream pool(BinaryResultsPoolPath(target_path), mode);
+		if (!append_to_target)
+		{
+			BinaryResultsHeader header = MakeBinaryResultsHeader();
+			records.write(reinterpret_cast<const char *>(&header), sizeof(header));
+			records.flush();
+		}
+
+		for (const std::string &source_path : pack.second)
+		{
+			{
+				BinaryResultsFile source;
+				if (records.fail() || pool.fail() || !source.Open(source_path))
+				{
+					unread_sources.insert(source_path);
+					continue;
+				}
+
+				// Match lists stay 8-byte aligned as long as the pool base is
+				size_t padding = static_cast<size_t>((8 - pool_size % 8) % 8);
+				pool_size += padding;
+
+				std::string source_pool = source.Pool();
+				std::string source_records;
+				for (size_t i = 0; i < source.Size(); ++i)
+				{
+					BinaryResultRecord record = source[i];
+					record.image_name.offset += pool_size;
+					record.image_path.offset += pool_size;
+					for (BinaryString &field : record.fields)
+					{
+						field.offset += pool_size;
+					}
+
+					BinaryMatch *matches = reinterpret_cast<BinaryMatch *>(&source_pool[0] + record.matches_offset);
+					for (uint32_t j = 0; j < record.match_count; ++j)
+					{
+						matches[j].type.offset += pool_size;
+					}
+					record.matches_offset += pool_size;
+
+					source_records.append(reinterpret_cast<const char *>(&record), sizeof(record));
+				}
+
+				pool.write("\0\0\0\0\0\0\0", static_cast<std::streamsize>(padding));
+				pool.write(source_pool.data(), static_cast<std::streamsize>(source_pool.size()));
+				pool.flush();
+				pool_size += source_pool.size();
+				if (!pool.fail())
+				{
+					records.write(source_records.data(), static_cast<std::streamsize>(source_records.size()));
+					records.flush();
+				}
+				if (records.fail() || pool.fail())
+				{
+					unread_sources.insert(source_path);
+					continue;
+				}
+			}
+
+			if (remove_sources)
+			{
+				std::remove(source_path.c_str());
+				std::remove(BinaryResultsPoolPath(source_path).c_str());
+			}
+		}
+	}
+	return unread_sources;
+}
+
+#endif // SMARTENGINES_RECOGNIZER_BINARY_RESULTS_H
@@ -0,0 +1,85 @@
+#ifndef SMARTENGINES_RECOGNIZER_BOUNDED_QUEUE_H
+#define SMARTENGINES_RECOGNIZER_BOUNDED_QUEUE_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+// Multi-producer multi-consumer FIFO with a fixed capacity. Push blocks
+// while the queue is full, which gives producers backpressure instead of
+// letting the backlog grow without bound.
+template <typename T>
+class BoundedQueue
+{
+	std::mutex mutex;
+	std::condition_variable not_empty;
+	std::condition_variable not_full;
+	std::deque<T> items;
+	size_t capacity;
+	bool closed = false;
+
+public:
+	explicit BoundedQueue(size_t queue_capacity)
+		: capacity(std::max<size_t>(queue_capacity, 1))
+	{
+	}
+
+	// Returns false if the queue has been closed.
+	bool Push(T item)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		not_full.wait(lock, [this]() { return closed || items.size() < capacity; });
+		if (closed)
+		{
+			return false;
+		}
+
+		items.push_back(std::move(item));
+		not_empty.notify_one();
+		return true;
+	}
+
+	// Blocks until an item is available. Returns false once the queue is
+	// closed and drained.
+	bool Pop(T &item)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		not_empty.wait(lock, [this]() { return closed || !items.empty(); });
+		if (items.empty())
+		{
+			return false;
+		}
+
+		item = std::move(items.front());
+		items.pop_front();
+		not_full.notify_one();
+		return true;
+	}
+
+	// Returns false right away if the queue is empty
+	bool TryPop(T &item)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (items.empty())
+		{
+			return false;
+		}
+
+		item = std::move(items.front());
+		items.pop_front();
+		not_full.notify_one();
+		return true;
+	}
+
+	// Wakes up every waiting thread; items already queued can still be popped.
+	void Close()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closed = true;
+		not_empty.notify_all();
+		not_full.notify_all();
+	}
+};
+
+#endif // SMARTENGINES_RECOGNIZER_BOUNDED_QUEUE_H
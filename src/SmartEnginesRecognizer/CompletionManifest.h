@@ -0,0 +1,93 @@
+#ifndef SMARTENGINES_RECOGNIZER_COMPLETION_MANIFEST_H
+#define SMARTENGINES_RECOGNIZER_COMPLETION_MANIFEST_H
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+// Modification time in seconds, with sub-second precision where the file
+// system provides it. Returns false if the file does not exist.
+inline bool GetModificationTime(const std::string &path, double &mtime)
+{
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0)
+	{
+		return false;
+	}
+
+#if defined(__linux__)
+	mtime = info.st_mtim.tv_sec + info.st_mtim.tv_nsec / 1e9;
+#elif defined(__APPLE__)
+	mtime = info.st_mtimespec.tv_sec + info.st_mtimespec.tv_nsec / 1e9;
+#else
+	mtime = static_cast<double>(info.st_mtime);
+#endif
+	return true;
+}
+
+// Append-only log of images whose result file has been written completely,
+// one "pack/image" entry per line. A result file that exists but is not
+// listed may have been cut short by a crash and is recognized again.
+class CompletionManifest
+{
+	std::string path;
+	std::unordered_set<std::string> entries;
+	std::ofstream log;
+	std::mutex mutex;
+
+public:
+	// Loads the existing entries when resuming, otherwise starts a new log
+	CompletionManifest(const std::string &manifest_path, bool resume)
+		: path(manifest_path)
+	{
+		if (resume)
+		{
+			ReadEntries(path, entries);
+		}
+
+		log.open(path, resume ? std::ios::app : std::ios::trunc);
+	}
+
+	static void ReadEntries(const std::string &manifest_path, std::unordered_set<std::string> &manifest_entries)
+	{
+		std::ifstream existing(manifest_path);
+		std::string entry;
+		while (std::getline(existing, entry))
+		{
+			if (!entry.empty())
+			{
+				manifest_entries.insert(entry);
+			}
+		}
+	}
+
+	// Treats the entries of another manifest as completed, without writing them
+	void Include(const std::string &manifest_path)
+	{
+		ReadEntries(manifest_path, entries);
+	}
+
+	bool Contains(const std::string &entry) const
+	{
+		return entries.find(entry) != entries.end();
+	}
+
+	size_t Size() const
+	{
+		return entries.size();
+	}
+
+	// Thread-safe; every entry is flushed so that it survives a crash
+	void Append(const std::string &entry)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		log << entry << '\n';
+		log.flush();
+	}
+};
+
+#endif // SMARTENGINES_RECOGNIZER_COMPLETION_MANIFEST_H
@@ -0,0 +1,176 @@
+#ifndef SMARTENGINES_RECOGNIZER_DATA_DIRECTORY_H
+#define SMARTENGINES_RECOGNIZER_DATA_DIRECTORY_H
+
+#include "tinydir/tinydir.h"
+
+#ifdef _WIN32
+#include <direct.h>
+#include <fcntl.h>
+#include <io.h>
+#include <share.h>
+#include <sys/stat.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Creates a single directory level; an existing directory is not an error
+inline void MakeDirectory(const std::string &path)
+{
+#ifdef _WIN32
+	_mkdir(path.c_str());
+#else
+	mkdir(path.c_str(), 0755);
+#endif
+}
+
+inline unsigned long long FileSize(const std::string &path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	std::streamoff size = file ? static_cast<std::streamoff>(file.tellg()) : 0;
+	return size > 0 ? static_cast<unsigned long long>(size) : 0;
+}
+
+// Moves from over to, replacing it in one step, so that readers see either
+// the old file or the complete new one
+inline bool ReplaceFile(const std::string &from, const std::string &to)
+{
+#ifdef _WIN32
+	return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+// Cuts an existing file down to size bytes
+inline bool TruncateFile(const std::string &path, unsigned long long size)
+{
+#ifdef _WIN32
+	int fd = -1;
+	if (_sopen_s(&fd, path.c_str(), _O_RDWR | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE) != 0)
+	{
+		return false;
+	}
+	bool truncated = _chsize_s(fd, static_cast<__int64>(size)) == 0;
+	_close(fd);
+	return truncated;
+#else
+	return truncate(path.c_str(), static_cast<off_t>(size)) == 0;
+#endif
+}
+
+// "pack/image" paths as they appear in manifests
+inline std::string PackOf(const std::string &relative_path)
+{
+	return relative_path.substr(0, relative_path.find('/'));
+}
+
+inline std::string ImageNameOf(const std::string &relative_path)
+{
+	size_t slash = relative_path.find('/');
+	return slash == std::string::npos ? relative_path : relative_path.substr(slash + 1);
+}
+
+struct ImageTask
+{
+	std::string relative_path;
+	std::string image_path;
+	std::string result_file_path;
+};
+
+// Calls handle(task) for every image of every data pack in directory order;
+// result files go to result_dir_path/pack/image.json
+template <typename Handler>
+void EnumerateImages(const std::string &data_path, const std::string &result_dir_path, bool create_result_dirs, Handler handle)
+{
+	tinydir_dir data_dir;
+	if (tinydir_open(&data_dir, data_path.c_str()) == -1)
+	{
+		std::cout << std::endl;
+		std::cout << "Failed to open data directory" << std::endl;
+		return;
+	}
+
+	while (data_dir.has_next)
+	{
+		tinydir_file data_pack_dir_file;
+		if (tinydir_readfile(&data_dir, &data_pack_dir_file) != -1 && data_pack_dir_file.is_dir &&
+			strcmp(data_pack_dir_file.name, ".") != 0 && strcmp(data_pack_dir_file.name, "..") != 0)
+		{
+			std::string pack_result_dir_path = result_dir_path + "/" + data_pack_dir_file.name;
+			if (create_result_dirs)
+			{
+				MakeDirectory(pack_result_dir_path);
+			}
+
+			tinydir_dir data_pack_dir;
+			if (tinydir_open(&data_pack_dir, data_pack_dir_file.path) != -1)
+			{
+				while (data_pack_dir.has_next)
+				{
+					tinydir_file data_pack_image_file;
+					if (tinydir_readfile(&data_pack_dir, &data_pack_image_file) != -1 && data_pack_image_file.is_reg)
+					{
+						ImageTask task;
+						task.relative_path = std::string(data_pack_dir_file.name) + "/" + data_pack_image_file.name;
+						task.image_path = data_pack_image_file.path;
+						task.result_file_path = pack_result_dir_path + "/" + data_pack_image_file.name + ".json";
+						handle(task);
+					}
+
+					tinydir_next(&data_pack_dir);
+				}
+
+				tinydir_close(&data_pack_dir);
+			}
+		}
+
+		tinydir_next(&data_dir);
+	}
+
+	tinydir_close(&data_dir);
+}
+
+// Finds the per-pack output files "<pack><suffix><extension>" in the result
+// directory for any of the given suffixes, as paths grouped by pack
+inline std::map<std::string, std::vector<std::string>> FindPackFiles(const std::string &result_dir_path, const std::vector<std::string> &suffixes, const std::string &extension)
+{
+	std::map<std::string, std::vector<std::string>> pack_files;
+
+	tinydir_dir result_dir;
+	if (tinydir_open(&result_dir, result_dir_path.c_str()) == -1)
+	{
+		return pack_files;
+	}
+
+	while (result_dir.has_next)
+	{
+		tinydir_file file;
+		if (tinydir_readfile(&result_dir, &file) != -1 && file.is_reg)
+		{
+			std::string name = file.name;
+			for (const std::string &suffix : suffixes)
+			{
+				std::string ending = suffix + extension;
+				if (name.size() > ending.size() && name.compare(name.size() - ending.size(), ending.size(), ending) == 0)
+				{
+					pack_files[name.substr(0, name.size() - ending.size())].push_back(result_dir_path + "/" + name);
+				}
+			}
+		}
+		tinydir_next(&result_dir);
+	}
+	tinydir_close(&result_dir);
+
+	return pack_files;
+}
+
+#endif // SMARTENGINES_RECOGNIZER_DATA_DIRECTORY_H
@@ -0,0 +1,319 @@
+#ifndef SMARTENGINES_RECOGNIZER_IMAGE_PREFETCHER_H
+#define SMARTENGINES_RECOGNIZER_IMAGE_PREFETCHER_H
+
+#include "smartengines/passport_common.h"
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Image read ahead of recognition. Uncompressed formats (binary PGM/PPM and
+// 24/32-bit BMP) are decoded into pixels and can go to ProcessSnapshot;
+// anything else (JPEG in our data packs) is still handed to
+// ProcessImageFile, which then reads the file from the warm page cache.
+struct PrefetchedImage
+{
+	bool loaded = false;
+	bool decoded = false;
+
+	std::vector<unsigned char> pixels;
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+
+	PassportImage Snapshot()
+	{
+		PassportImage image;
+		image.data = pixels.data();
+		image.width = width;
+		image.height = height;
+		image.stride = width * channels;
+		image.channels = channels;
+		return image;
+	}
+};
+
+namespace image_decoding
+{
+	// Larger BMP headers are rejected before any size is computed from them
+	const int max_bmp_dimension = 1 << 16;
+
+	inline void SkipPnmSpace(const std::vector<char> &bytes, size_t &pos)
+	{
+		while (pos < bytes.size())
+		{
+			if (bytes[pos] == '#')
+			{
+				while (pos < bytes.size() && bytes[pos] != '\n')
+				{
+					++pos;
+				}
+			}
+			else if (bytes[pos] == ' ' || bytes[pos] == '\t' || bytes[pos] == '\r' || bytes[pos] == '\n')
+			{
+				++pos;
+			}
+			else
+			{
+				break;
+			}
+		}
+	}
+
+	inline int ReadPnmNumber(const std::vector<char> &bytes, size_t &pos)
+	{
+		SkipPnmSpace(bytes, pos);
+
+		int value = 0;
+		bool has_digits = false;
+		while (pos < bytes.size() && bytes[pos] >= '0' && bytes[pos] <= '9' && value < 1000000)
+		{
+			value = value * 10 + (bytes[pos++] - '0');
+			has_digits = true;
+		}
+		return has_digits ? value : -1;
+	}
+
+	// Binary PGM (P5) and PPM (P6) with 8-bit samples
+	inline bool DecodePnm(const std::vector<char> &bytes, PrefetchedImage &image)
+	{
+		if (bytes.size() < 2 || bytes[0] != 'P' || (bytes[1] != '5' && bytes[1] != '6'))
+		{
+			return false;
+		}
+
+		size_t pos = 2;
+		int width = ReadPnmNumber(bytes, pos);
+		int height = ReadPnmNumber(bytes, pos);
+		int max_value = ReadPnmNumber(bytes, pos);
+		if (width <= 0 || height <= 0 || max_value <= 0 || max_value > 255 || pos >= bytes.size())
+		{
+			return false;
+		}
+		++pos; // single whitespace before the raster
+
+		int channels = bytes[1] == '6' ? 3 : 1;
+		size_t row_length = static_cast<size_t>(width) * channels;
+		if ((bytes.size() - pos) / row_length < static_cast<size_t>(height))
+		{
+			return false;
+		}
+		size_t length = row_length * height;
+
+		image.pixels.assign(bytes.begin() + pos, bytes.begin() + pos + length);
+		image.width = width;
+		image.height = height;
+		image.channels = channels;
+		return true;
+	}
+
+	inline unsigned ReadLittleEndian(const std::vector<char> &bytes, size_t pos, size_t size)
+	{
+		unsigned value = 0;
+		for (size_t i = 0; i < size; ++i)
+		{
+			value |= static_cast<unsigned>(static_cast<unsigned char>(bytes[pos + i])) << (8 * i);
+		}
+		return value;
+	}
+
+	// Uncompressed 24/32-bit BMP, converted to top-down RGB(A)
+	inline bool DecodeBmp(const std::vector<char> &bytes, PrefetchedImage &image)
+	{
+		if (bytes.size() < 54 || bytes[0] != 'B' || bytes[1] != 'M')
+		{
+			return false;
+		}
+
+		size_t offset = ReadLittleEndian(bytes, 10, 4);
+		int width = static_cast<int>(ReadLittleEndian(bytes, 18, 4));
+		int height = static_cast<int>(ReadLittleEndian(bytes, 22, 4));
+		unsigned bits = ReadLittleEndian(bytes, 28, 2);
+		unsigned compression = ReadLittleEndian(bytes, 30, 4);
+		if (width <= 0 || width > max_bmp_dimension || height == 0 || height < -max_bmp_dimension || height > max_bmp_dimension ||
+			(bits != 24 && bits != 32) || compression != 0)
+		{
+			return false;
+		}
+
+		bool bottom_up = height > 0;
+		height = bottom_up ? height : -height;
+
+		int channels = bits / 8;
+		size_t row_length = (static_cast<size_t>(width) * channels + 3) & ~static_cast<size_t>(3);
+		if (offset > bytes.size() || (bytes.size() - offset) / row_length < static_cast<size_t>(height))
+		{
+			return false;
+		}
+
+		image.pixels.resize(static_cast<size_t>(width) * height * channels);
+		for (int y = 0; y < height; ++y)
+		{
+			const char *src = bytes.data() + offset + row_length * (bottom_up ? height - 1 - y : y);
+			unsigned char *dst = image.pixels.data() + static_cast<size_t>(y) * width * channels;
+			for (int x = 0; x < width; ++x, src += channels, dst += channels)
+			{
+				dst[0] = src[2];
+				dst[1] = src[1];
+				dst[2] = src[0];
+				if (channels == 4)
+				{
+					dst[3] = src[3];
+				}
+			}
+		}
+
+		image.width = width;
+		image.height = height;
+		image.channels = channels;
+		return true;
+	}
+}
+
+inline PrefetchedImage LoadImage(const std::string &path)
+{
+	PrefetchedImage image;
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		return image;
+	}
+
+	std::vector<char> bytes;
+	file.seekg(0, std::ios::end);
+	std::streamoff size = file.tellg();
+	file.seekg(0, std::ios::beg);
+	if (size > 0)
+	{
+		bytes.resize(static_cast<size_t>(size));
+		file.read(bytes.data(), size);
+		if (file.gcount() != size)
+		{
+			return image;
+		}
+	}
+
+	image.loaded = true;
+	image.decoded = image_decoding::DecodePnm(bytes, image) || image_decoding::DecodeBmp(bytes, image);
+	return image;
+}
+
+// Per-worker read-ahead window: keeps the next depth tasks of a worker
+// queued for a loader thread of its own, which reads them one after the
+// other while the current one is being recognized. A depth of 0 disables
+// read-ahead, starts no thread and returns images that are not loaded.
+template <typename Task>
+class ImagePrefetcher
+{
+	typedef std::pair<Task, std::future<PrefetchedImage>> Entry;
+
+	std::function<bool(Task &)> next_task;
+	size_t depth;
+	std::deque<Entry> window;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<std::packaged_task<PrefetchedImage()>> pending;
+	bool stopping = false;
+	std::thread loader;
+
+public:
+	ImagePrefetcher(size_t prefetch_depth, std::function<bool(Task &)> task_source)
+		: next_task(task_source), depth(prefetch_depth)
+	{
+		if (depth > 0)
+		{
+			loader = std::thread([this]() { Load(); });
+		}
+	}
+
+	~ImagePrefetcher()
+	{
+		if (loader.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			wake.notify_one();
+			loader.join();
+		}
+	}
+
+	bool Next(Task &task, PrefetchedImage &image)
+	{
+		if (depth == 0)
+		{
+			image = PrefetchedImage();
+			return next_task(task);
+		}
+
+		Fill();
+		if (window.empty())
+		{
+			return false;
+		}
+
+		// Off the window before get(), which rethrows a failed load: the
+		// caller gets the task and may carry on with the next one
+		task = std::move(window.front().first);
+		std::future<PrefetchedImage> loaded = std::move(window.front().second);
+		window.pop_front();
+		image = loaded.get();
+
+		Fill();
+		return true;
+	}
+
+private:
+	void Fill()
+	{
+		while (window.size() < depth)
+		{
+			Task task;
+			if (!next_task(task))
+			{
+				return;
+			}
+
+			std::string path = task.image_path;
+			std::packaged_task<PrefetchedImage()> load([path]() { return LoadImage(path); });
+			window.emplace_back(std::move(task), load.get_future());
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				pending.push_back(std::move(load));
+			}
+			wake.notify_one();
+		}
+	}
+
+	// Loads queued images in order until the prefetcher is destroyed
+	void Load()
+	{
+		for (;;)
+		{
+			std::packaged_task<PrefetchedImage()> load;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [this]() { return stopping || !pending.empty(); });
+				if (stopping)
+				{
+					return;
+				}
+				load = std::move(pending.front());
+				pending.pop_front();
+			}
+			load();
+		}
+	}
+};
+
+#endif // SMARTENGINES_RECOGNIZER_IMAGE_PREFETCHER_H
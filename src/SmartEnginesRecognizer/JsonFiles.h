@@ -0,0 +1,71 @@
+#ifndef SMARTENGINES_RECOGNIZER_JSON_FILES_H
+#define SMARTENGINES_RECOGNIZER_JSON_FILES_H
+
+#include "MappedFile.h"
+
+#include "jsoncons/json.hpp"
+
+#include <string>
+#include <vector>
+
+// Reading many JSON files such as result files: every file is parsed in
+// place by a json_reader over its contents, with no stream and no buffer
+// refills. Large files are mapped; small ones are read into a buffer that
+// is reused from file to file, which costs less than a mapping each.
+class JsonFileParser
+{
+	MappedFile file;
+
+public:
+	static const size_t min_mapped_size = 64 * 1024;
+
+	// Sends the events of the JSON text in the file to handler. Returns
+	// false if the file cannot be read or does not hold valid JSON.
+	bool Parse(const std::string &path, jsoncons::json_input_handler &handler)
+	{
+		if (!file.Open(path, min_mapped_size))
+		{
+			return false;
+		}
+
+		bool parsed = true;
+		try
+		{
+			jsoncons::json_reader reader(file.Data(), file.Size(), handler);
+			reader.read_next();
+			reader.check_done();
+		}
+		catch (...) {
+			parsed = false;
+		}
+		file.Close();
+		return parsed;
+	}
+};
+
+// Parses each file of paths into a json value and calls loaded(path, value)
+// for it, or failed(path) if it cannot be read. Returns the number of files
+// loaded.
+template <typename Loaded, typename Failed>
+size_t LoadJsonFiles(const std::vector<std::string> &paths, Loaded loaded, Failed failed)
+{
+	JsonFileParser parser;
+	jsoncons::basic_json_deserializer<jsoncons::json> handler;
+
+	size_t loaded_count = 0;
+	for (const std::string &path : paths)
+	{
+		if (parser.Parse(path, handler) && handler.is_valid())
+		{
+			loaded(path, handler.get_result());
+			++loaded_count;
+		}
+		else
+		{
+			failed(path);
+		}
+	}
+	return loaded_count;
+}
+
+#endif // SMARTENGINES_RECOGNIZER_JSON_FILES_H
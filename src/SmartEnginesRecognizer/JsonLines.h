@@ -0,0 +1,315 @@
+#ifndef SMARTENGINES_RECOGNIZER_JSON_LINES_H
+#define SMARTENGINES_RECOGNIZER_JSON_LINES_H
+
+#include "DataDirectory.h"
+#include "ResultReporter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+// JSON Lines output: all results of a data pack go to "<pack>.jsonl", one
+// compact record per line, instead of one file per image. The sidecar
+// "<pack>.jsonl.idx" has an "image<TAB>offset<TAB>length" line for every
+// record, written only after the record itself. Records are only ever
+// appended, so when an image occurs more than once its last line wins.
+// Before appending, both files are cut back to their last complete index
+// line, dropping whatever a crash left half written.
+
+inline std::string JsonLinesPath(const std::string &result_dir_path, const std::string &relative_path, const std::string &file_suffix)
+{
+	return result_dir_path + "/" + PackOf(relative_path) + file_suffix + ".jsonl";
+}
+
+inline std::string JsonLinesIndexPath(const std::string &json_lines_path)
+{
+	return json_lines_path + ".idx";
+}
+
+// Splits an "image<TAB>offset<TAB>length" index line, false if it is not one
+inline bool ParseJsonLinesIndexLine(const std::string &line, std::string &image_name, unsigned long long &offset, unsigned long long &length)
+{
+	size_t name_end = line.find('\t');
+	if (name_end == std::string::npos || name_end == 0)
+	{
+		return false;
+	}
+
+	const char *field = line.c_str() + name_end + 1;
+	const char *line_end = line.c_str() + line.size();
+	unsigned long long values[2];
+	for (int i = 0; i < 2; ++i)
+	{
+		if (*field < '0' || *field > '9')
+		{
+			return false;
+		}
+		char *end = nullptr;
+		values[i] = strtoull(field, &end, 10);
+		if (i == 0 ? *end != '\t' : end != line_end)
+		{
+			return false;
+		}
+		field = end + 1;
+	}
+
+	image_name = line.substr(0, name_end);
+	offset = values[0];
+	length = values[1];
+	return true;
+}
+
+// Cuts the index back to its last complete line and the records back to
+// the end of the last indexed record. Returns the size of the records.
+inline unsigned long long RepairJsonLines(const std::string &json_lines_path)
+{
+	std::string index_path = JsonLinesIndexPath(json_lines_path);
+	std::string index_text;
+	{
+		std::ifstream index(index_path, std::ios::binary);
+		index_text.assign(std::istreambuf_iterator<char>(index), std::istreambuf_iterator<char>());
+	}
+
+	size_t index_end = index_text.rfind('\n');
+	index_end = index_end == std::string::npos ? 0 : index_end + 1;
+	if (index_end < index_text.size())
+	{
+		TruncateFile(index_path, index_end);
+	}
+
+	unsigned long long records_end = 0;
+	size_t line_start = 0;
+	while (line_start < index_end)
+	{
+		size_t line_end = index_text.find('\n', line_start);
+		std::string image_name;
+		unsigned long long offset = 0, length = 0;
+		if (ParseJsonLinesIndexLine(index_text.substr(line_start, line_end - line_start), image_name, offset, length))
+		{
+			records_end = std::max(records_end, offset + length + 1);
+		}
+		line_start = line_end + 1;
+	}
+
+	unsigned long long records_size = FileSize(json_lines_path);
+	if (records_size > records_end)
+	{
+		TruncateFile(json_lines_path, records_end);
+		records_size = records_end;
+	}
+	return records_size;
+}
+
+// Records and index lines of one pack, collected in memory by Add and
+// written out in one go by Flush
+class JsonLinesPack
+{
+	std::string path;
+	std::ofstream records;
+	std::ofstream index;
+	unsigned long long records_size;
+
+	std::string record_buffer;
+	std::string index_buffer;
+	std::vector<std::string> buffered_entries;
+
+public:
+	JsonLinesPack(const std::string &json_lines_path, bool append)
+		: path(json_lines_path)
+	{
+		std::ios::openmode mode = std::ios::binary | (append ? std::ios::app : std::ios::trunc);
+		records_size = append ? RepairJsonLines(path) : 0;
+		records.open(path, mode);
+		index.open(JsonLinesIndexPath(path), mode);
+	}
+
+	const std::string &Path() const
+	{
+		return path;
+	}
+
+	size_t BufferedBytes() const
+	{
+		return record_buffer.size();
+	}
+
+	void Add(const std::string &relative_path, ImageResult &result)
+	{
+		size_t start = record_buffer.size();
+		{
+			jsoncons::string_sink sink(record_buffer);
+			WriteResultRecord(sink, result);
+		}
+		size_t length = record_buffer.size() - start;
+		record_buffer.push_back('\n');
+
+		index_buffer += ImageNameOf(relative_path);
+		index_buffer += '\t';
+		index_buffer += std::to_string(records_size + start);
+		index_buffer += '\t';
+		index_buffer += std::to_string(length);
+		index_buffer += '\n';
+
+		buffered_entries.push_back(relative_path);
+	}
+
+	// Calls complete(entry) for every record that is now in both files
+	template <typename Complete>
+	bool Flush(Complete complete)
+	{
+		if (record_buffer.empty())
+		{
+			return true;
+		}
+
+		records.write(record_buffer.data(), record_buffer.size());
+		records.flush();
+		if (!records.fail())
+		{
+			index.write(index_buffer.data(), index_buffer.size());
+			index.flush();
+		}
+
+		bool written = !records.fail() && !index.fail();
+		if (written)
+		{
+			for (const std::string &entry : buffered_entries)
+			{
+				complete(entry);
+			}
+			records_size += record_buffer.size();
+		}
+
+		record_buffer.clear();
+		index_buffer.clear();
+		buffered_entries.clear();
+		return written;
+	}
+};
+
+// Batches the records of every pack up to batch_bytes before writing
+class JsonLinesWriter
+{
+	std::string result_dir_path;
+	std::string file_suffix;
+	bool append;
+	size_t batch_bytes;
+	std::map<std::string, std::unique_ptr<JsonLinesPack>> packs;
+
+public:
+	JsonLinesWriter(const std::string &result_dir, const std::string &suffix, bool append_to_existing, size_t batch_size = 1 << 20)
+		: result_dir_path(result_dir), file_suffix(suffix), append(append_to_existing), batch_bytes(batch_size)
+	{
+	}
+
+	// complete(entry) is called once a record is written out, failed(path)
+	// if writing a pack file fails
+	template <typename Complete, typename Failed>
+	void Write(const std::string &relative_path, ImageResult &result, Complete complete, Failed failed)
+	{
+		std::unique_ptr<JsonLinesPack> &pack = packs[PackOf(relative_path)];
+		if (!pack)
+		{
+			pack.reset(new JsonLinesPack(JsonLinesPath(result_dir_path, relative_path, file_suffix), append));
+		}
+
+		pack->Add(relative_path, result);
+		if (pack->BufferedBytes() >= batch_bytes && !pack->Flush(complete))
+		{
+			failed(pack->Path());
+		}
+	}
+
+	template <typename Complete, typename Failed>
+	void Flush(Complete complete, Failed failed)
+	{
+		for (auto &pack : packs)
+		{
+			if (!pack.second->Flush(complete))
+			{
+				failed(pack.second->Path());
+			}
+		}
+	}
+};
+
+// Appends the records of "<pack><from>.jsonl" for each of from_suffixes to
+// "<pack><to_suffix>.jsonl" in the same directory, with the index lines
+// shifted accordingly. Target files are restarted unless append is set.
+// Like a pack writer, every source goes in records first, index second,
+// both flushed. Returns the sources that could not be read or written out;
+// they are never removed, and nothing more is appended to a target that
+// failed.
+inline std::set<std::string> MergeJsonLines(const std::string &result_dir_path, const std::vector<std::string> &from_suffixes, const std::string &to_suffix, bool append, bool remove_sources)
+{
+	std::set<std::string> unread_sources;
+	std::map<std::string, std::vector<std::string>> sources = FindPackFiles(result_dir_path, from_suffixes, ".jsonl");
+
+	for (auto &pack : sources)
+	{
+		std::string target_path = result_dir_path + "/" + pack.first + to_suffix + ".jsonl";
+		std::ios::openmode mode = std::ios::binary | (append ? std::ios::app : std::ios::trunc);
+		unsigned long long target_size = append ? RepairJsonLines(target_path) : 0;
+
+		std::ofstream records(target_path, mode);
+		std::ofstream index(JsonLinesIndexPath(target_path), mode);
+
+		for (const std::string &source_path : pack.second)
+		{
+			unsigned long long source_size = RepairJsonLines(source_path);
+			std::ifstream source_records(source_path, std::ios::binary);
+			std::ifstream source_index(JsonLinesIndexPath(source_path), std::ios::binary);
+			if (records.fail() || index.fail() || !source_records || !source_index)
+			{
+				unread_sources.insert(source_path);
+				continue;
+			}
+
+			if (source_size > 0)
+			{
+				records << source_records.rdbuf();
+			}
+			records.flush();
+
+			if (!records.fail())
+			{
+				std::string line;
+				while (std::getline(source_index, line))
+				{
+					std::string image_name;
+					unsigned long long offset = 0, length = 0;
+					if (ParseJsonLinesIndexLine(line, image_name, offset, length))
+					{
+						index << image_name << '\t' << (target_size + offset) << '\t' << length << '\n';
+					}
+				}
+				index.flush();
+			}
+
+			target_size += source_size;
+			source_records.close();
+			source_index.close();
+			if (records.fail() || index.fail())
+			{
+				unread_sources.insert(source_path);
+				continue;
+			}
+
+			if (remove_sources)
+			{
+				std::remove(source_path.c_str());
+				std::remove(JsonLinesIndexPath(source_path).c_str());
+			}
+		}
+	}
+	return unread_sources;
+}
+
+#endif // SMARTENGINES_RECOGNIZER_JSON_LINES_H
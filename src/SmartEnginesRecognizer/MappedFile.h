@@ -0,0 +1,158 @@
+#ifndef SMARTENGINES_RECOGNIZER_MAPPED_FILE_H
+#define SMARTENGINES_RECOGNIZER_MAPPED_FILE_H
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Read-only memory mapping of a whole file. An empty file maps to no data
+// but still counts as open. Files below min_mapped_size are read into a
+// buffer that is kept from one Open to the next instead, since for small
+// files that costs less than setting up a mapping.
+class MappedFile
+{
+	const char *data;
+	size_t size;
+	bool open;
+	bool mapped;
+	std::vector<char> buffer;
+
+public:
+	MappedFile()
+		: data(nullptr), size(0), open(false), mapped(false)
+	{
+	}
+
+	~MappedFile()
+	{
+		Close();
+	}
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	bool Open(const std::string &path, size_t min_mapped_size = 0)
+	{
+		Close();
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0)
+		{
+			open = true;
+		}
+		else if (static_cast<unsigned long long>(file_size.QuadPart) < min_mapped_size)
+		{
+			buffer.resize(static_cast<size_t>(file_size.QuadPart));
+			DWORD bytes_read = 0;
+			open = ReadFile(file, buffer.data(), static_cast<DWORD>(buffer.size()), &bytes_read, nullptr) && bytes_read == buffer.size();
+			data = open ? buffer.data() : nullptr;
+			size = open ? buffer.size() : 0;
+		}
+		else
+		{
+			HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping != nullptr)
+			{
+				data = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				CloseHandle(mapping);
+			}
+			size = data ? static_cast<size_t>(file_size.QuadPart) : 0;
+			open = mapped = data != nullptr;
+		}
+		CloseHandle(file);
+#else
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd == -1)
+		{
+			return false;
+		}
+
+		struct stat info;
+		if (fstat(fd, &info) != 0 || info.st_size <= 0)
+		{
+			open = true;
+		}
+		else if (static_cast<unsigned long long>(info.st_size) < min_mapped_size)
+		{
+			buffer.resize(static_cast<size_t>(info.st_size));
+			size_t done = 0;
+			while (done < buffer.size())
+			{
+				ssize_t count = ::read(fd, buffer.data() + done, buffer.size() - done);
+				if (count <= 0)
+				{
+					break;
+				}
+				done += static_cast<size_t>(count);
+			}
+			open = done == buffer.size();
+			data = open ? buffer.data() : nullptr;
+			size = open ? buffer.size() : 0;
+		}
+		else
+		{
+			void *mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+			if (mapping != MAP_FAILED)
+			{
+				data = static_cast<const char *>(mapping);
+				size = static_cast<size_t>(info.st_size);
+				open = mapped = true;
+			}
+		}
+		::close(fd);
+#endif
+
+		return open;
+	}
+
+	void Close()
+	{
+		if (mapped)
+		{
+#ifdef _WIN32
+			UnmapViewOfFile(data);
+#else
+			munmap(const_cast<char *>(data), size);
+#endif
+		}
+
+		data = nullptr;
+		size = 0;
+		open = false;
+		mapped = false;
+	}
+
+	const char *Data() const
+	{
+		return data;
+	}
+
+	size_t Size() const
+	{
+		return size;
+	}
+};
+
+#endif // SMARTENGINES_RECOGNIZER_MAPPED_FILE_H
@@ -0,0 +1,101 @@
+#ifndef SMARTENGINES_RECOGNIZER_PASSPORT_FIELDS_H
+#define SMARTENGINES_RECOGNIZER_PASSPORT_FIELDS_H
+
+#include "smartengines/passport_engine.h"
+
+#include <cstddef>
+#include <string>
+#include <tuple>
+#include <utility>
+
+// Compile-time table of the fields of PassportRecognitionResult. Every
+// entry has the field's output name with its length and a pointer to the
+// member; the member type selects how the value is turned into text. The
+// output formats iterate the table with ForEachPassportField, which is
+// unrolled at compile time, so names are constants and no keys are built.
+
+template <typename Field>
+struct PassportFieldInfo
+{
+	const char *name;
+	size_t name_length;
+	Field PassportRecognitionResult::*member;
+
+	const Field &Of(const PassportRecognitionResult &result) const
+	{
+		return result.*member;
+	}
+};
+
+template <typename Field, size_t Length>
+constexpr PassportFieldInfo<Field> MakePassportField(const char (&name)[Length], Field PassportRecognitionResult::*member)
+{
+	return PassportFieldInfo<Field>{ name, Length - 1, member };
+}
+
+// Sorted by name, the order a json object prints its members in
+constexpr auto passport_fields = std::make_tuple(
+	MakePassportField("authority",      &PassportRecognitionResult::authority),
+	MakePassportField("authority_code", &PassportRecognitionResult::authority_code),
+	MakePassportField("birthdate",      &PassportRecognitionResult::birthdate),
+	MakePassportField("birthplace",     &PassportRecognitionResult::birthplace),
+	MakePassportField("gender",         &PassportRecognitionResult::gender),
+	MakePassportField("issue_date",     &PassportRecognitionResult::issue_date),
+	MakePassportField("mrz_line1",      &PassportRecognitionResult::mrz_line1),
+	MakePassportField("mrz_line2",      &PassportRecognitionResult::mrz_line2),
+	MakePassportField("name",           &PassportRecognitionResult::name),
+	MakePassportField("number",         &PassportRecognitionResult::number),
+	MakePassportField("patronymic",     &PassportRecognitionResult::patronymic),
+	MakePassportField("series",         &PassportRecognitionResult::series),
+	MakePassportField("surname",        &PassportRecognitionResult::surname));
+
+const size_t passport_field_count = std::tuple_size<decltype(passport_fields)>::value;
+
+constexpr bool NameEquals(const char *name, const char *other)
+{
+	return *name == *other && (*name == '\0' || NameEquals(name + 1, other + 1));
+}
+
+template <size_t Index, size_t Length>
+constexpr bool IsPassportField(const char (&name)[Length])
+{
+	return NameEquals(std::get<Index>(passport_fields).name, name);
+}
+
+// Text of a field value: the value itself for string fields, ToString() for
+// dates, codes and gender
+template <typename Field>
+struct PassportFieldText
+{
+	static std::string Get(const Field &field)
+	{
+		return field.ToString();
+	}
+};
+
+template <>
+struct PassportFieldText<PassportStringField>
+{
+	static const std::string &Get(const PassportStringField &field)
+	{
+		return field.value;
+	}
+};
+
+template <typename Visitor, size_t... Indices>
+void ForEachPassportField(Visitor &&visit, std::index_sequence<Indices...>)
+{
+	// Expands to visit(field 0), visit(field 1), ... in table order
+	int expand[] = { 0, (visit(std::integral_constant<size_t, Indices>(), std::get<Indices>(passport_fields)), 0)... };
+	(void)expand;
+}
+
+// Calls visit(index, info) for every field in table order, where index is a
+// std::integral_constant and info the field's PassportFieldInfo
+template <typename Visitor>
+void ForEachPassportField(Visitor &&visit)
+{
+	ForEachPassportField(std::forward<Visitor>(visit), std::make_index_sequence<passport_field_count>());
+}
+
+#endif // SMARTENGINES_RECOGNIZER_PASSPORT_FIELDS_H
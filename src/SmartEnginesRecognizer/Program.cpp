@@ -6,209 +6,714 @@ using jsoncons::pretty_print;
 
 #include "tinydir/tinydir.h"
 
-#include <direct.h>
+#include "BinaryResults.h"
+#include "BoundedQueue.h"
+#include "CompletionManifest.h"
+#include "DataDirectory.h"
+#include "ImagePrefetcher.h"
+#include "JsonLines.h"
+#include "ResultReporter.h"
+#include "Sharding.h"
+#include "Stopwatch.h"
+#include "WorkStealingScheduler.h"
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
 #define RECOGNIZER_ID "smartengines"
 
-double diffclock(clock_t end, clock_t start)
+std::mutex console_mutex;
+
+struct PendingResult
 {
-	double ticks = end - start;
-	return ticks / (CLOCKS_PER_SEC / 1000);
-}
+	std::string manifest_entry;
+	std::string path;
+	ImageResult result;
+};
 
-json ValueToJson(PassportStringField field)
+// Serializes and writes result files on a dedicated thread fed through a
+// bounded queue, so recognition threads never wait on the file system; they
+// only block when the writer falls more than queue_capacity results behind.
+// Every complete result file is recorded in the manifest.
+// With JSON Lines or binary output, records are batched per pack and
+// written out whenever the batch is full or the queue runs empty.
+class ResultWriter
 {
-	json result;
-	result["value"] = field.value;
-	result["confidence"] = field.is_accepted ? "1" : "0";
-	return result;
-}
+	CompletionManifest *manifest;
+	JsonLinesWriter *json_lines;
+	BinaryResultsWriter *binary;
+	BoundedQueue<PendingResult> queue;
+	std::thread thread;
+
+public:
+	ResultWriter(size_t queue_capacity, CompletionManifest *completion_manifest, JsonLinesWriter *json_lines_writer = nullptr, BinaryResultsWriter *binary_writer = nullptr)
+		: manifest(completion_manifest), json_lines(json_lines_writer), binary(binary_writer), queue(queue_capacity), thread([this]() { Run(); })
+	{
+	}
+
+	~ResultWriter()
+	{
+		Finish();
+	}
+
+	void Write(PendingResult result)
+	{
+		queue.Push(std::move(result));
+	}
+
+	// Drains the queue and stops the writer thread
+	void Finish()
+	{
+		queue.Close();
+		if (thread.joinable())
+		{
+			thread.join();
+		}
+	}
+
+private:
+	void Run()
+	{
+		auto complete = [this](const std::string &entry) { manifest->Append(entry); };
+		auto failed = [](const std::string &path)
+		{
+			std::lock_guard<std::mutex> lock(console_mutex);
+			std::cout << std::endl;
+			std::cout << "Write exception: " << path << std::endl;
+		};
+
+		PendingResult pending;
+		while (true)
+		{
+			if (!queue.TryPop(pending))
+			{
+				if (json_lines)
+				{
+					json_lines->Flush(complete, failed);
+				}
+				if (binary)
+				{
+					binary->Flush(complete, failed);
+				}
+				if (!queue.Pop(pending))
+				{
+					break;
+				}
+			}
 
-json ValueToJson(PassportGenderField field)
+			try
+			{
+				if (json_lines)
+				{
+					json_lines->Write(pending.manifest_entry, pending.result, complete, failed);
+				}
+				else if (binary)
+				{
+					binary->Write(pending.manifest_entry, pending.result, complete, failed);
+				}
+				else if (WriteResultFile(pending.path, pending.result))
+				{
+					manifest->Append(pending.manifest_entry);
+				}
+			}
+			catch (...) {
+				failed(pending.path);
+			}
+		}
+	}
+};
+
+void ProcessImageTask(PassportEngine *engine, const ImageTask &task, PrefetchedImage &image, ResultWriter &writer)
 {
-	json result;
-	result["value"] = field.ToString();
-	result["confidence"] = field.is_accepted ? "1" : "0";
-	return result;
+	try
+	{
+		{
+			std::lock_guard<std::mutex> lock(console_mutex);
+			std::cout << task.image_path << std::endl;
+		}
+
+		ResultReporter reporter(engine, task.image_path);
+		reporter.ProcessImage(image);
+
+		PendingResult pending;
+		pending.manifest_entry = task.relative_path;
+		pending.path = task.result_file_path;
+		pending.result = std::move(reporter.result);
+		writer.Write(std::move(pending));
+	}
+	catch (...) {
+		std::lock_guard<std::mutex> lock(console_mutex);
+		std::cout << std::endl;
+		std::cout << "File exception: " << task.image_path << std::endl;
+	}
 }
 
-json ValueToJson(PassportDateField field)
+void RunWorkers(WorkStealingScheduler<ImageTask> &scheduler, const std::vector<PassportEngine *> &engines, size_t prefetch, ResultWriter &writer)
 {
-	json result;
-	result["value"] = field.ToString();
-	result["confidence"] = field.is_accepted ? "1" : "0";
-	return result;
+	std::vector<std::thread> workers;
+	for (size_t worker = 0; worker < engines.size(); ++worker)
+	{
+		PassportEngine *worker_engine = engines[worker];
+		workers.emplace_back([&scheduler, &writer, worker, worker_engine, prefetch]()
+		{
+			ImagePrefetcher<ImageTask> prefetcher(prefetch, [&scheduler, worker](ImageTask &task)
+			{
+				return scheduler.Pop(worker, task);
+			});
+
+			ImageTask task;
+			PrefetchedImage image;
+			while (true)
+			{
+				try
+				{
+					if (!prefetcher.Next(task, image))
+					{
+						break;
+					}
+				}
+				catch (...) {
+					// Reading ahead failed for this image only
+					std::lock_guard<std::mutex> lock(console_mutex);
+					std::cout << std::endl;
+					std::cout << "File exception: " << task.image_path << std::endl;
+					continue;
+				}
+				ProcessImageTask(worker_engine, task, image, writer);
+			}
+		});
+	}
+
+	for (auto &worker : workers)
+	{
+		worker.join();
+	}
 }
 
-json ValueToJson(PassportCodeField field)
+enum ResultFormat
 {
-	json result;
-	result["value"] = field.ToString();
-	result["confidence"] = field.is_accepted ? "1" : "0";
-	return result;
-}
+	result_files,       // one JSON file per image
+	result_json_lines,  // --jsonl, see JsonLines.h
+	result_binary       // --binary, see BinaryResults.h
+};
 
-struct ResultReporter : PassportResultReporterInterface
+struct Options
 {
-	PassportEngine *engine;
+	std::string data_path = "../../data/";
+	std::string result_path = "../../result/";
+	std::string config_path = "data/passport_anywhere.json";
+	int threads = 1;
+	int write_queue = 256;
+	int prefetch = 0;
+	bool incremental = false;
+	ResultFormat result_format = result_files;
+	ShardSpec shard;
+	int merge_shards = 0;
+	int processes = 0;
+
+	// Set for forked worker processes only: entries of this manifest count
+	// as done too, and the worker's own manifest is resumed, not restarted
+	std::string base_manifest_path;
+	std::string base_file_suffix;
+	bool resume_manifest = false;
+};
 
-	clock_t start;
-	clock_t end;
-	double time;
+Options ParseOptions(int argc, char **argv)
+{
+	Options options;
 
-	std::string image_path;
-	bool snapshot_rejected = false;
-	json matches = json::array();
-	json data;
+	std::vector<std::string> args;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--threads" && i + 1 < argc)
+		{
+			options.threads = atoi(argv[++i]);
+			if (options.threads <= 0)
+			{
+				options.threads = std::max(1u, std::thread::hardware_concurrency());
+			}
+		}
+		else if (arg == "--write-queue" && i + 1 < argc)
+		{
+			options.write_queue = std::max(1, atoi(argv[++i]));
+		}
+		else if (arg == "--prefetch" && i + 1 < argc)
+		{
+			options.prefetch = std::max(0, atoi(argv[++i]));
+		}
+		else if (arg == "--incremental")
+		{
+			options.incremental = true;
+		}
+		else if (arg == "--jsonl")
+		{
+			options.result_format = result_json_lines;
+		}
+		else if (arg == "--binary")
+		{
+			options.result_format = result_binary;
+		}
+		else if (arg == "--shard" && i + 1 < argc)
+		{
+			if (!options.shard.Parse(argv[++i]))
+			{
+				std::cout << "Invalid shard " << argv[i] << ", expected i/N with 0 <= i < N" << std::endl;
+				exit(1);
+			}
+		}
+		else if (arg == "--processes" && i + 1 < argc)
+		{
+			options.processes = std::max(0, atoi(argv[++i]));
+		}
+		else if (arg == "--merge-shards" && i + 1 < argc)
+		{
+			options.merge_shards = std::max(1, atoi(argv[++i]));
+		}
+		else
+		{
+			args.push_back(arg);
+		}
+	}
 
-	explicit ResultReporter(PassportEngine *passportEngine, std::string path)
+	if (args.size() == 3)
 	{
-		engine = passportEngine;
-		image_path = path;
+		options.data_path = args[0];
+		options.result_path = args[1];
+		options.config_path = args[2];
 	}
 
-	void ProcessImage()
+	return options;
+}
+
+// The file that holds the result of an image when results are written per pack
+std::string PackResultPath(const Options &options, const std::string &relative_path, const std::string &file_suffix)
+{
+	std::string result_dir_path = options.result_path + RECOGNIZER_ID;
+	if (options.result_format == result_binary)
 	{
-		start = clock();
+		return BinaryResultsPath(result_dir_path, relative_path, file_suffix);
+	}
+	return JsonLinesPath(result_dir_path, relative_path, file_suffix);
+}
 
-		engine->InitializeSession(*this);
-		engine->ProcessImageFile(image_path);
-		engine->TerminateSession();
+// Returns the pack files that could not be merged and were left in place
+std::set<std::string> MergePackResults(const Options &options, const std::vector<std::string> &from_suffixes, const std::string &to_suffix, bool append, bool remove_sources)
+{
+	std::string result_dir_path = options.result_path + RECOGNIZER_ID;
+	std::set<std::string> unread_sources = options.result_format == result_binary ?
+		MergeBinaryResults(result_dir_path, from_suffixes, to_suffix, append, remove_sources) :
+		MergeJsonLines(result_dir_path, from_suffixes, to_suffix, append, remove_sources);
 
-		end = clock();
-		time = diffclock(end, start);
+	for (const std::string &source : unread_sources)
+	{
+		std::cout << "Cannot merge " << source << ", its images are left out" << std::endl;
 	}
+	return unread_sources;
+}
 
-	std::string GetResult() const
+// The result is reused if it was written completely after both the image
+// and the engine configuration were last changed. Results written per pack
+// have no file of their own; the pack file they were appended to stands in,
+// and a worker process also accepts the one of the run that started it.
+// An empty path stands for a result file that cannot be used.
+bool IsResultUpToDate(const ImageTask &task, const CompletionManifest &manifest, double config_mtime, const std::string &result_path, const std::string &base_result_path)
+{
+	if (!manifest.Contains(task.relative_path))
 	{
-		json result;
-		result["image_path"] = image_path;
-		result["snapshot_rejected"] = snapshot_rejected;
-		result["matches"] = matches;
-		result["data"] = data;
-		result["time"] = time;
-		
-		return result.as_string();
+		return false;
 	}
 
-	virtual void SnapshotRejected() override
+	double image_mtime, result_mtime, base_result_mtime;
+	if (!GetModificationTime(task.image_path, image_mtime))
+	{
+		return false;
+	}
+	if (result_path.empty() || !GetModificationTime(result_path, result_mtime))
 	{
-		snapshot_rejected = true;
+		result_mtime = 0;
+	}
+	if (!base_result_path.empty() && GetModificationTime(base_result_path, base_result_mtime))
+	{
+		result_mtime = std::max(result_mtime, base_result_mtime);
+	}
+	if (result_mtime == 0)
+	{
+		return false;
 	}
 
-	virtual void DocumentMatched(const PassportMatchResult &result, PassportImageRequest &request) override
+	return result_mtime >= image_mtime && result_mtime >= config_mtime;
+}
+
+void ProcessData(const Options &options, const std::vector<PassportEngine *> &engines)
+{
+	tinydir_dir result_dir;
+	if (tinydir_open(&result_dir, options.result_path.c_str()) == -1)
 	{
-		json match;
-		match["score"] = result.score;
-		match["type"] = result.type;
-		matches.add(match);
+		std::cout << std::endl;
+		std::cout << "Failed to open result directory" << std::endl;
+	}
+	else
+	{
+		tinydir_close(&result_dir);
 	}
 
-	virtual void SnapshotProcessed(const PassportRecognitionResult &result, bool may_finish, bool is_break) override
+	CompletionManifest manifest(options.result_path + RECOGNIZER_ID + "/" + options.shard.ManifestName(), options.incremental || options.resume_manifest);
+	if (!options.base_manifest_path.empty())
 	{
-		data["enough_data"]    = may_finish;
-		data["series"]         = ValueToJson(result.series);
-		data["number"]         = ValueToJson(result.number);
-		data["surname"]        = ValueToJson(result.surname);
-		data["name"]           = ValueToJson(result.name);
-		data["patronymic"]     = ValueToJson(result.patronymic);
-		data["gender"]         = ValueToJson(result.gender);
-		data["birthdate"]      = ValueToJson(result.birthdate);
-		data["birthplace"]     = ValueToJson(result.birthplace);
-		data["authority"]      = ValueToJson(result.authority);
-		data["issue_date"]     = ValueToJson(result.issue_date);
-		data["authority_code"] = ValueToJson(result.authority_code);
-		data["mrz_line1"]      = ValueToJson(result.mrz_line1);
-		data["mrz_line2"]      = ValueToJson(result.mrz_line2);
+		manifest.Include(options.base_manifest_path);
 	}
-};
 
-void ProcessData(std::string data_path, std::string result_path, PassportEngine *engine)
-{
-	tinydir_dir data_dir;
-	if (tinydir_open(&data_dir, data_path.c_str()) == -1)
+	double config_mtime = 0;
+	GetModificationTime(options.config_path, config_mtime);
+
+	WorkStealingScheduler<ImageTask> scheduler(engines.size());
+	size_t skipped = 0;
+	size_t foreign = 0;
+
+	// A binary pack file of another layout holds no usable results; it is
+	// set aside once its pack is written again
+	std::map<std::string, bool> readable_packs;
+	auto usable_result_path = [&](const std::string &path)
+	{
+		if (options.result_format != result_binary || path.empty())
+		{
+			return path;
+		}
+		auto readable = readable_packs.find(path);
+		if (readable == readable_packs.end())
+		{
+			BinaryResultsFile results;
+			readable = readable_packs.emplace(path, results.Open(path)).first;
+		}
+		return readable->second ? path : std::string();
+	};
+
+	std::string result_dir_path = options.result_path + RECOGNIZER_ID;
+	EnumerateImages(options.data_path, result_dir_path, options.result_format == result_files, [&](ImageTask &task)
 	{
+		std::string base_result_path;
+		if (options.result_format != result_files)
+		{
+			task.result_file_path = PackResultPath(options, task.relative_path, options.shard.FileSuffix());
+			if (!options.base_manifest_path.empty())
+			{
+				base_result_path = PackResultPath(options, task.relative_path, options.base_file_suffix);
+			}
+		}
+
+		if (options.shard.IsSharded() && !options.shard.Owns(task.relative_path))
+		{
+			++foreign;
+		}
+		else if (options.incremental && IsResultUpToDate(task, manifest, config_mtime, usable_result_path(task.result_file_path), usable_result_path(base_result_path)))
+		{
+			++skipped;
+		}
+		else
+		{
+			scheduler.Push(task);
+		}
+	});
+
+	if (options.shard.IsSharded())
+	{
+		std::cout << "Shard " << options.shard.index << "/" << options.shard.count << " leaves " << foreign << " images to other shards" << std::endl;
 		std::cout << std::endl;
-		std::cout << "Failed to open data directory" << std::endl;
 	}
 
-	tinydir_dir result_dir;
-	if (tinydir_open(&result_dir, result_path.c_str()) == -1)
+	if (options.incremental)
 	{
+		std::cout << "Skipped " << skipped << " up-to-date images" << std::endl;
 		std::cout << std::endl;
-		std::cout << "Failed to open result directory" << std::endl;
 	}
 
-	while (data_dir.has_next)
+	bool append = options.incremental || options.resume_manifest;
+	std::unique_ptr<JsonLinesWriter> json_lines;
+	std::unique_ptr<BinaryResultsWriter> binary;
+	if (options.result_format == result_json_lines)
+	{
+		json_lines.reset(new JsonLinesWriter(result_dir_path, options.shard.FileSuffix(), append));
+	}
+	else if (options.result_format == result_binary)
+	{
+		binary.reset(new BinaryResultsWriter(result_dir_path, options.shard.FileSuffix(), append));
+	}
+
+	ResultWriter writer(options.write_queue, &manifest, json_lines.get(), binary.get());
+	RunWorkers(scheduler, engines, options.prefetch, writer);
+	writer.Finish();
+}
+
+#ifndef _WIN32
+const int max_worker_restarts = 3;
+
+pid_t StartWorkerProcess(const Options &options, PassportEngine *engine)
+{
+	std::cout.flush();
+
+	pid_t pid = fork();
+	if (pid != 0)
+	{
+		return pid;
+	}
+
+	int status = 0;
+	try {
+		ProcessData(options, std::vector<PassportEngine *>(1, engine));
+	}
+	catch (const PassportException &e) {
+		std::cout << std::endl;
+		std::cout << "Exception: " << e.what() << std::endl;
+		status = 1;
+	}
+	catch (...) {
+		// Nothing may unwind past the fork into the parent's code
+		std::cout << std::endl;
+		std::cout << "Worker process exception" << std::endl;
+		status = 1;
+	}
+
+	std::cout.flush();
+	_exit(status);
+}
+
+// Pre-fork mode: the engine is configured once in the parent, and the
+// worker processes share its model pages copy-on-write, so memory grows
+// with the number of configs rather than with the number of workers.
+// Worker j runs sub-shard (i + N*j) of N*processes of the run's shard i/N,
+// which partitions exactly the images of shard i/N; its files carry a
+// "-worker" suffix to keep them apart from those of a "--shard" run. A
+// worker that crashes is restarted and resumes from its own manifest; the
+// manifests of all workers are merged into the shard manifest at the end.
+void RunWorkerProcesses(const Options &options, PassportEngine *engine)
+{
+	std::string manifest_dir = options.result_path + RECOGNIZER_ID + "/";
+	CompletionManifest manifest(manifest_dir + options.shard.ManifestName(), options.incremental);
+
+	std::vector<Options> worker_options(options.processes, options);
+	for (int j = 0; j < options.processes; ++j)
 	{
-		tinydir_file data_pack_dir_file;
-		if (tinydir_readfile(&data_dir, &data_pack_dir_file) != -1 && data_pack_dir_file.is_dir)
+		worker_options[j].shard.index = options.shard.index + options.shard.count * j;
+		worker_options[j].shard.count = options.shard.count * options.processes;
+		worker_options[j].shard.worker_process = true;
+		worker_options[j].processes = 0;
+		if (options.incremental)
 		{
-			std::string result_dir_path = result_path + RECOGNIZER_ID + "/" + data_pack_dir_file.name;
-			_mkdir(result_dir_path.c_str());
+			worker_options[j].base_manifest_path = manifest_dir + options.shard.ManifestName();
+			worker_options[j].base_file_suffix = options.shard.FileSuffix();
+		}
+	}
+
+	std::map<pid_t, int> running;
+	std::vector<int> restarts(options.processes, 0);
+	for (int j = 0; j < options.processes; ++j)
+	{
+		running[StartWorkerProcess(worker_options[j], engine)] = j;
+	}
 
-			tinydir_dir data_pack_dir;
-			if (tinydir_open(&data_pack_dir, data_pack_dir_file.path) != -1)
+	while (!running.empty())
+	{
+		int status = 0;
+		pid_t pid = waitpid(-1, &status, 0);
+		if (pid == -1)
+		{
+			if (errno == EINTR)
 			{
-				while (data_pack_dir.has_next)
-				{
-					tinydir_file data_pack_image_file;
+				continue;
+			}
+			break;
+		}
 
-					try
-					{
-						if (tinydir_readfile(&data_pack_dir, &data_pack_image_file) != -1 && data_pack_image_file.is_reg)
-						{
-							std::cout << data_pack_image_file.path << std::endl;
+		auto it = running.find(pid);
+		if (it == running.end())
+		{
+			continue;
+		}
+
+		int j = it->second;
+		running.erase(it);
 
-							auto reporter = new ResultReporter(engine, data_pack_image_file.path);
-							reporter->ProcessImage();
-							auto result = reporter->GetResult();
+		if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+		{
+			continue;
+		}
 
-							auto result_file_path = result_path + RECOGNIZER_ID + "/" + data_pack_dir_file.name + "/" + data_pack_image_file.name + ".json";
+		std::cout << std::endl;
+		if (restarts[j] < max_worker_restarts)
+		{
+			++restarts[j];
+			std::cout << "Worker process " << j << " failed, restarting (" << restarts[j] << "/" << max_worker_restarts << ")" << std::endl;
 
-							std::ofstream result_file;
-							result_file.open(result_file_path);
-							result_file << result;
-							result_file.close();
-						}
-					}
-					catch (...) {
-						std::cout << std::endl;
-						std::cout << "File exception: " << data_pack_image_file.path << std::endl;
-					}
+			worker_options[j].incremental = true;
+			worker_options[j].resume_manifest = true;
+			running[StartWorkerProcess(worker_options[j], engine)] = j;
+		}
+		else
+		{
+			std::cout << "Worker process " << j << " failed " << (max_worker_restarts + 1) << " times, giving up on its images" << std::endl;
+		}
+	}
 
-					tinydir_next(&data_pack_dir);
-				}
+	// Records first: the manifest must not list a record before it is in place
+	std::set<std::string> unread_sources;
+	if (options.result_format != result_files)
+	{
+		std::vector<std::string> worker_suffixes;
+		for (int j = 0; j < options.processes; ++j)
+		{
+			worker_suffixes.push_back(worker_options[j].shard.FileSuffix());
+		}
+		unread_sources = MergePackResults(options, worker_suffixes, options.shard.FileSuffix(), options.incremental, true);
+	}
+
+	for (int j = 0; j < options.processes; ++j)
+	{
+		std::string worker_manifest_path = manifest_dir + worker_options[j].shard.ManifestName();
+
+		std::unordered_set<std::string> entries;
+		CompletionManifest::ReadEntries(worker_manifest_path, entries);
+		for (auto &entry : entries)
+		{
+			if (unread_sources.count(PackResultPath(options, entry, worker_options[j].shard.FileSuffix())) == 0)
+			{
+				manifest.Append(entry);
 			}
 		}
 
-		tinydir_next(&data_dir);
+		std::remove(worker_manifest_path.c_str());
 	}
 }
+#endif
+
+// Checks that the shards of a "--shard i/N" run together covered every
+// image: each image must be listed in the manifest of the shard it hashes
+// to and have a result file. Complete images are written to the unsharded
+// manifest, so an --incremental run can pick up whatever is missing.
+// With --jsonl or --binary the shards' pack files are copied into the
+// unsharded ones.
+// Returns the number of missing images.
+size_t MergeShards(const Options &options)
+{
+	std::string manifest_dir = options.result_path + RECOGNIZER_ID + "/";
 
-int main(int argc, char **argv) {
-	std::string data_path = "../../data/";
-	std::string result_path = "../../result/";
-	std::string config_path = "data/passport_anywhere.json";
+	ShardSpec spec;
+	spec.count = options.merge_shards;
 
-	if (argc == 4)
+	std::vector<std::unordered_set<std::string>> shard_entries(spec.count);
+	for (int i = 0; i < spec.count; ++i)
 	{
-		data_path = argv[1];
-		result_path = argv[2];
-		config_path = argv[3];
+		CompletionManifest::ReadEntries(manifest_dir + ShardSpec::ManifestName(i, spec.count), shard_entries[i]);
 	}
 
+	std::set<std::string> unread_sources;
+	if (options.result_format != result_files && spec.count > 1)
+	{
+		std::vector<std::string> shard_suffixes;
+		for (int i = 0; i < spec.count; ++i)
+		{
+			shard_suffixes.push_back(ShardSpec::FileSuffix(i, spec.count));
+		}
+		unread_sources = MergePackResults(options, shard_suffixes, "", false, false);
+	}
+
+	CompletionManifest merged(manifest_dir + ShardSpec::ManifestName(0, 1), false);
+	size_t total = 0;
+	size_t missing = 0;
+
+	EnumerateImages(options.data_path, options.result_path + RECOGNIZER_ID, false, [&](const ImageTask &task)
+	{
+		++total;
+
+		int shard = spec.ShardOf(task.relative_path);
+		std::string result_file_path = task.result_file_path;
+		if (options.result_format != result_files)
+		{
+			result_file_path = PackResultPath(options, task.relative_path, ShardSpec::FileSuffix(shard, spec.count));
+		}
+
+		double result_mtime;
+		if (shard_entries[shard].count(task.relative_path) != 0 && unread_sources.count(result_file_path) == 0 &&
+			GetModificationTime(result_file_path, result_mtime))
+		{
+			merged.Append(task.relative_path);
+		}
+		else
+		{
+			++missing;
+			std::cout << "Missing in shard " << shard << "/" << spec.count << ": " << task.image_path << std::endl;
+		}
+	});
+
 	std::cout << std::endl;
-	std::cout << "Data path:   " << data_path   << std::endl;
-	std::cout << "Result path: " << result_path << std::endl;
-	std::cout << "Config path: " << config_path << std::endl;
+	std::cout << "Merged " << spec.count << " shards: " << (total - missing) << " of " << total << " images complete" << std::endl;
+	return missing;
+}
+
+int main(int argc, char **argv) {
+	Options options = ParseOptions(argc, argv);
+
 	std::cout << std::endl;
+	std::cout << "Data path:   " << options.data_path   << std::endl;
+	std::cout << "Result path: " << options.result_path << std::endl;
+	std::cout << "Config path: " << options.config_path << std::endl;
+	if (options.processes > 0)
+	{
+		std::cout << "Processes:   " << options.processes << std::endl;
+	}
+	else
+	{
+		std::cout << "Threads:     " << options.threads << std::endl;
+	}
+	std::cout << std::endl;
+
+	if (options.merge_shards > 0)
+	{
+		return MergeShards(options) == 0 ? 0 : 1;
+	}
 
 	try {
-		PassportEngine engine;
-		engine.Configure(config_path);
+#ifndef _WIN32
+		if (options.processes > 0)
+		{
+			PassportEngine engine;
+			engine.Configure(options.config_path);
 
-		ProcessData(data_path, result_path, &engine);
+			RunWorkerProcesses(options, &engine);
+			return 0;
+		}
+#else
+		if (options.processes > 0)
+		{
+			std::cout << "--processes is not supported on Windows, using threads" << std::endl;
+		}
+#endif
+
+		std::vector<std::unique_ptr<PassportEngine>> engines;
+		std::vector<PassportEngine *> engine_pointers;
+		for (int i = 0; i < options.threads; ++i)
+		{
+			std::unique_ptr<PassportEngine> engine(new PassportEngine());
+			engine->Configure(options.config_path);
+			engine_pointers.push_back(engine.get());
+			engines.push_back(std::move(engine));
+		}
+
+		ProcessData(options, engine_pointers);
 	}
 	catch (const PassportException &e) {
 		std::cout << std::endl;
@@ -216,4 +721,4 @@ int main(int argc, char **argv) {
 	}
 
 	return 0;
-}
\ No newline at end of file
+}
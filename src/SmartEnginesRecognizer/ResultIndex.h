@@ -0,0 +1,399 @@
+#ifndef SMARTENGINES_RECOGNIZER_RESULT_INDEX_H
+#define SMARTENGINES_RECOGNIZER_RESULT_INDEX_H
+
+#include "tinydir/tinydir.h"
+
+#include "DataDirectory.h"
+#include "JsonFiles.h"
+#include "jsoncons/fd_sink.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Result index: the result files of every engine and pack under a result
+// directory ("<engine>/<pack>/<image>.json") in a single JSON file,
+//   {"<engine>": {"<pack>": {"<image>": {...}, ...}, ...}, ...}
+// where every result keeps only the members the dashboard reads. The files
+// are parsed in parallel and streamed into the index without building a
+// json tree; the index is then written in one go.
+
+// Forwards the events of a result to output, leaving out every top-level
+// member except the indexed ones
+class IndexedMembersFilter : public jsoncons::json_input_handler
+{
+	jsoncons::json_output_handler &output;
+	size_t depth = 0;
+	size_t skipped_depth = 0;
+	bool member_kept = true;
+
+	static bool IsIndexed(const char *name, size_t length)
+	{
+		static const char *const indexed[] = { "data", "failure", "matches", "time" };
+		for (const char *member : indexed)
+		{
+			if (strlen(member) == length && memcmp(member, name, length) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// True while inside a member that is left out
+	bool Skipping() const
+	{
+		return skipped_depth > 0 || (depth == 1 && !member_kept);
+	}
+
+	bool BeginStructure()
+	{
+		if (Skipping())
+		{
+			++skipped_depth;
+			return false;
+		}
+		++depth;
+		return true;
+	}
+
+	bool EndStructure()
+	{
+		if (skipped_depth > 0)
+		{
+			--skipped_depth;
+			return false;
+		}
+		--depth;
+		return true;
+	}
+
+public:
+	explicit IndexedMembersFilter(jsoncons::json_output_handler &output_handler)
+		: output(output_handler)
+	{
+	}
+
+private:
+	virtual void do_begin_json() override
+	{
+		depth = 0;
+		skipped_depth = 0;
+		member_kept = true;
+		output.begin_json();
+	}
+
+	virtual void do_end_json() override
+	{
+		output.end_json();
+	}
+
+	virtual void do_begin_object(const jsoncons::parsing_context &) override
+	{
+		if (BeginStructure())
+		{
+			output.begin_object();
+		}
+	}
+
+	virtual void do_end_object(const jsoncons::parsing_context &) override
+	{
+		if (EndStructure())
+		{
+			output.end_object();
+		}
+	}
+
+	virtual void do_begin_array(const jsoncons::parsing_context &) override
+	{
+		if (BeginStructure())
+		{
+			output.begin_array();
+		}
+	}
+
+	virtual void do_end_array(const jsoncons::parsing_context &) override
+	{
+		if (EndStructure())
+		{
+			output.end_array();
+		}
+	}
+
+	virtual void do_name(const char *name, size_t length, const jsoncons::parsing_context &) override
+	{
+		if (skipped_depth > 0)
+		{
+			return;
+		}
+		if (depth == 1)
+		{
+			member_kept = IsIndexed(name, length);
+			if (!member_kept)
+			{
+				return;
+			}
+		}
+		output.name(name, length);
+	}
+
+	virtual void do_null_value(const jsoncons::parsing_context &) override
+	{
+		if (!Skipping())
+		{
+			output.value(jsoncons::null_type());
+		}
+	}
+
+	virtual void do_string_value(const char *value, size_t length, const jsoncons::parsing_context &) override
+	{
+		if (!Skipping())
+		{
+			output.value(value, length);
+		}
+	}
+
+	virtual void do_double_value(double value, const jsoncons::parsing_context &) override
+	{
+		if (!Skipping())
+		{
+			output.value(value);
+		}
+	}
+
+	virtual void do_integer_value(int64_t value, const jsoncons::parsing_context &) override
+	{
+		if (!Skipping())
+		{
+			output.value(static_cast<long long>(value));
+		}
+	}
+
+	virtual void do_uinteger_value(uint64_t value, const jsoncons::parsing_context &) override
+	{
+		if (!Skipping())
+		{
+			output.value(static_cast<unsigned long long>(value));
+		}
+	}
+
+	virtual void do_bool_value(bool value, const jsoncons::parsing_context &) override
+	{
+		if (!Skipping())
+		{
+			output.value(value);
+		}
+	}
+};
+
+struct IndexedResult
+{
+	std::string engine;
+	std::string pack;
+	std::string image;  // file name without ".json", as in JSON Lines indexes
+	std::string path;
+	std::string members;  // the filtered result, empty if it could not be read
+};
+
+// Names of the subdirectories of path, sorted
+inline std::vector<std::string> ListDirectories(const std::string &path)
+{
+	std::vector<std::string> names;
+
+	tinydir_dir dir;
+	if (tinydir_open(&dir, path.c_str()) == -1)
+	{
+		return names;
+	}
+	while (dir.has_next)
+	{
+		tinydir_file file;
+		if (tinydir_readfile(&dir, &file) != -1 && file.is_dir && strcmp(file.name, ".") != 0 && strcmp(file.name, "..") != 0)
+		{
+			names.push_back(file.name);
+		}
+		tinydir_next(&dir);
+	}
+	tinydir_close(&dir);
+
+	std::sort(names.begin(), names.end());
+	return names;
+}
+
+// Every "<engine>/<pack>/<image>.json" under result_path, for the given
+// engines or all of them, in engine, pack and image order
+inline std::vector<IndexedResult> ListResultFiles(const std::string &result_path, const std::vector<std::string> &engines)
+{
+	static const std::string extension = ".json";
+
+	std::vector<IndexedResult> results;
+	for (const std::string &engine : engines.empty() ? ListDirectories(result_path) : engines)
+	{
+		std::string engine_path = result_path + "/" + engine;
+		for (const std::string &pack : ListDirectories(engine_path))
+		{
+			std::string pack_path = engine_path + "/" + pack;
+			size_t pack_start = results.size();
+
+			tinydir_dir dir;
+			if (tinydir_open(&dir, pack_path.c_str()) == -1)
+			{
+				continue;
+			}
+			while (dir.has_next)
+			{
+				tinydir_file file;
+				if (tinydir_readfile(&dir, &file) != -1 && file.is_reg)
+				{
+					std::string name = file.name;
+					if (name.size() > extension.size() && name.compare(name.size() - extension.size(), extension.size(), extension) == 0)
+					{
+						IndexedResult result;
+						result.engine = engine;
+						result.pack = pack;
+						result.image = name.substr(0, name.size() - extension.size());
+						result.path = pack_path + "/" + name;
+						results.push_back(std::move(result));
+					}
+				}
+				tinydir_next(&dir);
+			}
+			tinydir_close(&dir);
+
+			std::sort(results.begin() + pack_start, results.end(), [](const IndexedResult &a, const IndexedResult &b) { return a.image < b.image; });
+		}
+	}
+	return results;
+}
+
+// Fills in the members of every result with threads workers, each taking
+// the next batch of files. Returns the number of files that could not be
+// read.
+inline size_t ReadIndexedResults(std::vector<IndexedResult> &results, size_t threads)
+{
+	static const size_t batch_size = 64;
+
+	std::atomic<size_t> next(0);
+	std::atomic<size_t> failed_count(0);
+	std::vector<std::thread> workers;
+	for (size_t worker = 0; worker < std::max<size_t>(threads, 1); ++worker)
+	{
+		workers.emplace_back([&]()
+		{
+			JsonFileParser parser;
+			for (size_t start = next.fetch_add(batch_size); start < results.size(); start = next.fetch_add(batch_size))
+			{
+				for (size_t i = start; i < std::min(start + batch_size, results.size()); ++i)
+				{
+					IndexedResult &result = results[i];
+					bool parsed;
+					{
+						jsoncons::string_sink sink(result.members);
+						jsoncons::json_serializer serializer(sink, 1024);
+						IndexedMembersFilter filter(serializer);
+						parsed = parser.Parse(result.path, filter);
+					}
+					if (!parsed)
+					{
+						result.members.clear();
+						++failed_count;
+					}
+				}
+			}
+		});
+	}
+
+	for (auto &worker : workers)
+	{
+		worker.join();
+	}
+	return failed_count;
+}
+
+// Writes the results that could be read as the index at index_path, by way
+// of "<index_path>.tmp", so that the dashboard never reads a partial index.
+// Returns false if it cannot be written.
+inline bool WriteResultIndex(const std::string &index_path, const std::vector<IndexedResult> &results)
+{
+	std::string temp_path = index_path + ".tmp";
+	FILE *file = fopen(temp_path.c_str(), "wb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	bool written = true;
+	try
+	{
+		jsoncons::output_format format;
+		jsoncons::fd_sink sink(fileno(file));
+		jsoncons::buffered_ostream<char> os(sink, 256 * 1024, 4096);
+		auto write_name = [&](const std::string &name)
+		{
+			os.put('\"');
+			jsoncons::escape_string<char>(name.data(), name.size(), format, os);
+			os.put('\"');
+			os.put(':');
+		};
+
+		const IndexedResult *previous = nullptr;
+		os.put('{');
+		for (const IndexedResult &result : results)
+		{
+			if (result.members.empty())
+			{
+				continue;
+			}
+
+			bool new_engine = previous == nullptr || result.engine != previous->engine;
+			bool new_pack = new_engine || result.pack != previous->pack;
+			if (previous != nullptr)
+			{
+				if (new_pack)
+				{
+					os.put('}');
+				}
+				if (new_engine)
+				{
+					os.put('}');
+				}
+				os.put(',');
+			}
+			if (new_engine)
+			{
+				write_name(result.engine);
+				os.put('{');
+			}
+			if (new_pack)
+			{
+				write_name(result.pack);
+				os.put('{');
+			}
+			write_name(result.image);
+			os.write(result.members);
+			previous = &result;
+		}
+		if (previous != nullptr)
+		{
+			os.write("}}", 2);
+		}
+		os.put('}');
+		os.flush();
+	}
+	catch (...) {
+		written = false;
+	}
+
+	if (fclose(file) != 0 || !written || !ReplaceFile(temp_path, index_path))
+	{
+		std::remove(temp_path.c_str());
+		return false;
+	}
+	return true;
+}
+
+#endif // SMARTENGINES_RECOGNIZER_RESULT_INDEX_H
@@ -0,0 +1,89 @@
+// Builds the result index that src/app.js loads at startup instead of
+// reading every result file on its own, see ResultIndex.h.
+//
+// Arguments: [result-path [index-path]] [--threads N] [--engine name]...
+// The index goes to "<result-path>/index.json" by default; without --engine
+// every engine directory of the result path is indexed. Only per-image
+// result files are indexed: pack files written with --jsonl or --binary are
+// left out, and the dashboard reads those itself.
+
+#include "ResultIndex.h"
+#include "Stopwatch.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct IndexerOptions
+{
+	std::string result_path = "../../result/";
+	std::string index_path;
+	size_t threads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<std::string> engines;
+};
+
+IndexerOptions ParseOptions(int argc, char **argv)
+{
+	IndexerOptions options;
+
+	std::vector<std::string> args;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--threads" && i + 1 < argc)
+		{
+			int threads = atoi(argv[++i]);
+			if (threads > 0)
+			{
+				options.threads = threads;
+			}
+		}
+		else if (arg == "--engine" && i + 1 < argc)
+		{
+			options.engines.push_back(argv[++i]);
+		}
+		else
+		{
+			args.push_back(arg);
+		}
+	}
+
+	if (args.size() >= 1)
+	{
+		options.result_path = args[0];
+	}
+	if (args.size() >= 2)
+	{
+		options.index_path = args[1];
+	}
+	if (options.index_path.empty())
+	{
+		options.index_path = options.result_path + "/index.json";
+	}
+
+	return options;
+}
+
+int main(int argc, char **argv)
+{
+	IndexerOptions options = ParseOptions(argc, argv);
+
+	Stopwatch stopwatch;
+	std::vector<IndexedResult> results = ListResultFiles(options.result_path, options.engines);
+	size_t failed = ReadIndexedResults(results, options.threads);
+	if (!WriteResultIndex(options.index_path, results))
+	{
+		std::cout << "Cannot write " << options.index_path << std::endl;
+		return 1;
+	}
+
+	std::cout << "Indexed " << results.size() - failed << " results in " << stopwatch.Stop().wall_ms / 1000 << " s to " << options.index_path << std::endl;
+	if (failed > 0)
+	{
+		std::cout << failed << " result files could not be read" << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,280 @@
+#ifndef SMARTENGINES_RECOGNIZER_RESULT_REPORTER_H
+#define SMARTENGINES_RECOGNIZER_RESULT_REPORTER_H
+
+#include "smartengines/passport_engine.h"
+
+#include "jsoncons/json.hpp"
+
+#include "DataDirectory.h"
+#include "ImagePrefetcher.h"
+#include "PassportFields.h"
+#include "Stopwatch.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using jsoncons::json;
+using jsoncons::json_output_handler;
+using jsoncons::json_serializer;
+
+// Results are written as serializer events, without a json tree or an
+// intermediate string. Members are emitted in the sorted order a json
+// object would print them in, so the files stay the same byte for byte.
+
+template <size_t Length>
+void WriteName(json_output_handler &handler, const char (&name)[Length])
+{
+	handler.name(name, Length - 1);
+}
+
+template <typename Field>
+void WriteField(json_output_handler &handler, const PassportFieldInfo<Field> &info, const PassportRecognitionResult &data)
+{
+	const Field &field = info.Of(data);
+
+	handler.name(info.name, info.name_length);
+	handler.begin_object();
+	WriteName(handler, "confidence");
+	handler.value(field.is_accepted ? "1" : "0", 1);
+	WriteName(handler, "value");
+	handler.value(PassportFieldText<Field>::Get(field));
+	handler.end_object();
+}
+
+// "enough_data" is written among the fields, where its name sorts
+const size_t enough_data_position = 4;
+static_assert(IsPassportField<enough_data_position - 1>("birthplace") && IsPassportField<enough_data_position>("gender"),
+	"enough_data must sort right before passport_fields[enough_data_position]");
+
+inline void WritePhase(json_output_handler &handler, const PhaseTime &phase)
+{
+	handler.begin_object();
+	WriteName(handler, "cpu_ms");
+	handler.value(phase.cpu_ms);
+	WriteName(handler, "wall_ms");
+	handler.value(phase.wall_ms);
+	handler.end_object();
+}
+
+struct ResultTiming
+{
+	PhaseTime initialize_session;
+	PhaseTime process_image;
+	PhaseTime terminate_session;
+	PhaseTime build_json;
+	PhaseTime write_file;
+
+	void Write(json_output_handler &handler) const
+	{
+		handler.begin_object();
+		WriteName(handler, "build_json");
+		WritePhase(handler, build_json);
+		WriteName(handler, "initialize_session");
+		WritePhase(handler, initialize_session);
+		WriteName(handler, "process_image");
+		WritePhase(handler, process_image);
+		WriteName(handler, "terminate_session");
+		WritePhase(handler, terminate_session);
+		WriteName(handler, "write_file");
+		WritePhase(handler, write_file);
+		handler.end_object();
+	}
+};
+
+struct DocumentMatch
+{
+	double score;
+	std::string type;
+};
+
+// Everything the engine reported for one image, as it goes to the result file
+struct ImageResult
+{
+	std::string image_path;
+	bool snapshot_rejected = false;
+	std::vector<DocumentMatch> matches;
+
+	bool has_data = false;
+	bool enough_data = false;
+	PassportRecognitionResult data;
+
+	double time = 0;
+	ResultTiming timing;
+
+	// All members but "timing", see WriteResultFile
+	void WriteMembers(json_output_handler &handler) const
+	{
+		WriteName(handler, "data");
+		handler.begin_object();
+		if (has_data)
+		{
+			ForEachPassportField([&](auto index, const auto &info)
+			{
+				if (index == enough_data_position)
+				{
+					WriteName(handler, "enough_data");
+					handler.value(enough_data);
+				}
+				WriteField(handler, info, data);
+			});
+		}
+		handler.end_object();
+
+		WriteName(handler, "image_path");
+		handler.value(image_path);
+
+		WriteName(handler, "matches");
+		handler.begin_array();
+		for (const DocumentMatch &match : matches)
+		{
+			handler.begin_object();
+			WriteName(handler, "score");
+			handler.value(match.score);
+			WriteName(handler, "type");
+			handler.value(match.type);
+			handler.end_object();
+		}
+		handler.end_array();
+
+		WriteName(handler, "snapshot_rejected");
+		handler.value(snapshot_rejected);
+
+		WriteName(handler, "time");
+		handler.value(time);
+	}
+};
+
+struct ResultReporter : PassportResultReporterInterface
+{
+	PassportEngine *engine;
+	ImageResult result;
+
+	explicit ResultReporter(PassportEngine *passportEngine, std::string path)
+	{
+		engine = passportEngine;
+		result.image_path = path;
+	}
+
+	void ProcessImage(PrefetchedImage &prefetched)
+	{
+		ResultTiming &timing = result.timing;
+
+		Stopwatch stopwatch;
+		engine->InitializeSession(*this);
+		timing.initialize_session = stopwatch.Stop();
+
+		stopwatch.Start();
+		if (prefetched.decoded)
+		{
+			engine->ProcessSnapshot(prefetched.Snapshot());
+		}
+		else
+		{
+			engine->ProcessImageFile(result.image_path);
+		}
+		timing.process_image = stopwatch.Stop();
+
+		stopwatch.Start();
+		engine->TerminateSession();
+		timing.terminate_session = stopwatch.Stop();
+
+		result.time = timing.initialize_session.wall_ms + timing.process_image.wall_ms + timing.terminate_session.wall_ms;
+	}
+
+	virtual void SnapshotRejected() override
+	{
+		result.snapshot_rejected = true;
+	}
+
+	virtual void DocumentMatched(const PassportMatchResult &match_result, PassportImageRequest &request) override
+	{
+		DocumentMatch match;
+		match.score = match_result.score;
+		match.type = match_result.type;
+		result.matches.push_back(match);
+	}
+
+	virtual void SnapshotProcessed(const PassportRecognitionResult &recognition_result, bool may_finish, bool is_break) override
+	{
+		result.has_data = true;
+		result.enough_data = may_finish;
+		result.data = recognition_result;
+	}
+};
+
+// Serializes the result straight into "<path>.tmp", which then replaces the
+// file at path, so a run killed halfway never leaves a torn result behind.
+// "build_json" times the serialization of the members and "write_file"
+// opening the file and flushing them; "timing" sorts after all other
+// members, so it can be written last, once both are known.
+inline bool WriteResultFile(const std::string &path, ImageResult &result)
+{
+	std::string temp_path = path + ".tmp";
+
+	Stopwatch stopwatch;
+	std::ofstream result_file(temp_path);
+	PhaseTime open_file = stopwatch.Stop();
+
+	{
+		json_serializer serializer(result_file);
+
+		stopwatch.Start();
+		serializer.begin_json();
+		serializer.begin_object();
+		result.WriteMembers(serializer);
+		result.timing.build_json = stopwatch.Stop();
+
+		stopwatch.Start();
+		serializer.flush();
+		PhaseTime flush_file = stopwatch.Stop();
+		result.timing.write_file.wall_ms = open_file.wall_ms + flush_file.wall_ms;
+		result.timing.write_file.cpu_ms = open_file.cpu_ms + flush_file.cpu_ms;
+
+		WriteName(serializer, "timing");
+		result.timing.Write(serializer);
+		serializer.end_object();
+		serializer.end_json();
+	}
+
+	result_file.close();
+	if (result_file.fail() || !ReplaceFile(temp_path, path))
+	{
+		std::remove(temp_path.c_str());
+		return false;
+	}
+	return true;
+}
+
+// Serializes the whole result as a single line, for outputs that batch
+// their writes; "write_file" is left as it is.
+inline void WriteResultRecord(json_serializer &serializer, ImageResult &result)
+{
+	Stopwatch stopwatch;
+	serializer.begin_json();
+	serializer.begin_object();
+	result.WriteMembers(serializer);
+	result.timing.build_json = stopwatch.Stop();
+
+	WriteName(serializer, "timing");
+	result.timing.Write(serializer);
+	serializer.end_object();
+	serializer.end_json();
+}
+
+inline void WriteResultRecord(std::ostream &stream, ImageResult &result)
+{
+	json_serializer serializer(stream);
+	WriteResultRecord(serializer, result);
+}
+
+// A record is about a kilobyte, so a small buffer is enough for sinks that
+// need no large writes
+inline void WriteResultRecord(jsoncons::output_sink &sink, ImageResult &result)
+{
+	json_serializer serializer(sink, 1024);
+	WriteResultRecord(serializer, result);
+}
+
+#endif // SMARTENGINES_RECOGNIZER_RESULT_REPORTER_H
@@ -0,0 +1,94 @@
+#ifndef SMARTENGINES_RECOGNIZER_SHARDING_H
+#define SMARTENGINES_RECOGNIZER_SHARDING_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+// 64-bit FNV-1a. Must stay fixed: shard assignment of every image depends
+// on it, on every machine and across releases.
+inline uint64_t StableHash(const std::string &value)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (unsigned char c : value)
+	{
+		hash ^= c;
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+// Static partition of the data set: shard "index/count" owns every image
+// whose "pack/image" path hashes to index modulo count. Shards need no
+// coordination, so they can run on separate machines sharing one mount.
+struct ShardSpec
+{
+	int index = 0;
+	int count = 1;
+	bool worker_process = false;  // a sub-shard run by a --processes worker
+
+	bool IsSharded() const
+	{
+		return count > 1;
+	}
+
+	// Accepts "i/N" with 0 <= i < N
+	bool Parse(const std::string &spec)
+	{
+		size_t slash = spec.find('/');
+		if (slash == std::string::npos)
+		{
+			return false;
+		}
+
+		int parsed_index = atoi(spec.substr(0, slash).c_str());
+		int parsed_count = atoi(spec.substr(slash + 1).c_str());
+		if (parsed_count <= 0 || parsed_index < 0 || parsed_index >= parsed_count)
+		{
+			return false;
+		}
+
+		index = parsed_index;
+		count = parsed_count;
+		return true;
+	}
+
+	int ShardOf(const std::string &relative_path) const
+	{
+		return static_cast<int>(StableHash(relative_path) % static_cast<uint64_t>(count));
+	}
+
+	bool Owns(const std::string &relative_path) const
+	{
+		return ShardOf(relative_path) == index;
+	}
+
+	std::string ManifestName() const
+	{
+		return "manifest" + FileSuffix() + ".txt";
+	}
+
+	static std::string ManifestName(int shard_index, int shard_count)
+	{
+		return "manifest" + FileSuffix(shard_index, shard_count) + ".txt";
+	}
+
+	// Distinguishes the files each shard writes into a shared directory.
+	// Those of a worker process are marked as such, so they never clash with
+	// the files of a "--shard" run of the same index and count.
+	std::string FileSuffix() const
+	{
+		return FileSuffix(index, count) + (worker_process ? "-worker" : "");
+	}
+
+	static std::string FileSuffix(int shard_index, int shard_count)
+	{
+		if (shard_count <= 1)
+		{
+			return "";
+		}
+		return "-" + std::to_string(shard_index) + "-of-" + std::to_string(shard_count);
+	}
+};
+
+#endif // SMARTENGINES_RECOGNIZER_SHARDING_H
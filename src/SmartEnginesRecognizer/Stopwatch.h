@@ -0,0 +1,81 @@
+#ifndef SMARTENGINES_RECOGNIZER_STOPWATCH_H
+#define SMARTENGINES_RECOGNIZER_STOPWATCH_H
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <chrono>
+
+// CPU time consumed by the calling thread only, in milliseconds. Unlike
+// clock() it is not affected by the other recognition threads.
+inline double ThreadCpuMilliseconds()
+{
+#ifdef _WIN32
+	FILETIME creation_time, exit_time, kernel_time, user_time;
+	if (!GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time))
+	{
+		return 0;
+	}
+
+	ULARGE_INTEGER kernel, user;
+	kernel.LowPart = kernel_time.dwLowDateTime;
+	kernel.HighPart = kernel_time.dwHighDateTime;
+	user.LowPart = user_time.dwLowDateTime;
+	user.HighPart = user_time.dwHighDateTime;
+
+	// FILETIME counts 100 ns intervals
+	return (kernel.QuadPart + user.QuadPart) / 10000.0;
+#else
+	timespec now;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) != 0)
+	{
+		return 0;
+	}
+	return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+#endif
+}
+
+struct PhaseTime
+{
+	double wall_ms = 0;
+	double cpu_ms = 0;
+};
+
+// Measures monotonic wall time and thread CPU time of a single phase.
+// Start and Stop must be called on the same thread.
+class Stopwatch
+{
+	std::chrono::steady_clock::time_point wall_start;
+	double cpu_start;
+
+public:
+	Stopwatch()
+	{
+		Start();
+	}
+
+	void Start()
+	{
+		wall_start = std::chrono::steady_clock::now();
+		cpu_start = ThreadCpuMilliseconds();
+	}
+
+	PhaseTime Stop() const
+	{
+		PhaseTime phase;
+		phase.wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall_start).count();
+		phase.cpu_ms = ThreadCpuMilliseconds() - cpu_start;
+		return phase;
+	}
+};
+
+#endif // SMARTENGINES_RECOGNIZER_STOPWATCH_H
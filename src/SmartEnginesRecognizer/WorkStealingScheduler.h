@@ -0,0 +1,110 @@
+#ifndef SMARTENGINES_RECOGNIZER_WORK_STEALING_SCHEDULER_H
+#define SMARTENGINES_RECOGNIZER_WORK_STEALING_SCHEDULER_H
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Distributes tasks over per-worker deques. A worker takes tasks from the
+// front of its own deque; once it runs dry it steals half of the back of
+// the first non-empty deque of another worker, so a single huge data pack
+// does not leave the other workers idle at the end of the run.
+template <typename Task>
+class WorkStealingScheduler
+{
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+	size_t next_queue = 0;
+
+public:
+	explicit WorkStealingScheduler(size_t workers)
+	{
+		for (size_t i = 0; i < std::max<size_t>(workers, 1); ++i)
+		{
+			queues.emplace_back(new WorkerQueue());
+		}
+	}
+
+	size_t WorkerCount() const
+	{
+		return queues.size();
+	}
+
+	// Not thread-safe against itself: tasks are pushed by the single
+	// enumerating thread, round-robin across the workers.
+	void Push(Task task)
+	{
+		WorkerQueue &queue = *queues[next_queue];
+		next_queue = (next_queue + 1) % queues.size();
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(std::move(task));
+	}
+
+	// Returns false once every deque is empty.
+	bool Pop(size_t worker, Task &task)
+	{
+		{
+			WorkerQueue &own = *queues[worker];
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (!own.tasks.empty())
+			{
+				task = std::move(own.tasks.front());
+				own.tasks.pop_front();
+				return true;
+			}
+		}
+
+		return Steal(worker, task);
+	}
+
+private:
+	bool Steal(size_t worker, Task &task)
+	{
+		for (size_t offset = 1; offset < queues.size(); ++offset)
+		{
+			WorkerQueue &victim = *queues[(worker + offset) % queues.size()];
+
+			std::deque<Task> stolen;
+			{
+				std::lock_guard<std::mutex> lock(victim.mutex);
+				size_t count = (victim.tasks.size() + 1) / 2;
+				for (size_t i = 0; i < count; ++i)
+				{
+					stolen.push_front(std::move(victim.tasks.back()));
+					victim.tasks.pop_back();
+				}
+			}
+
+			if (stolen.empty())
+			{
+				continue;
+			}
+
+			task = std::move(stolen.front());
+			stolen.pop_front();
+
+			if (!stolen.empty())
+			{
+				WorkerQueue &own = *queues[worker];
+				std::lock_guard<std::mutex> lock(own.mutex);
+				for (auto &stolen_task : stolen)
+				{
+					own.tasks.push_back(std::move(stolen_task));
+				}
+			}
+			return true;
+		}
+
+		return false;
+	}
+};
+
+#endif // SMARTENGINES_RECOGNIZER_WORK_STEALING_SCHEDULER_H
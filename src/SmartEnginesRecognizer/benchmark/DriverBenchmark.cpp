@@ -0,0 +1,763 @@
+// Measures what the recognizer itself costs per image, with the stand-in
+// engine configured for zero latency. Every benchmark runs a batch of images
+// per repetition; inputs are prepared outside of the timed region and only
+// the timed region counts towards allocations.
+//
+// Arguments: [--images N] [--repetitions R] [--warmup W] [--filter text]
+//            [--work-dir path] [--format text|json]
+// With --format json every benchmark is printed as one JSON object per line.
+
+#include "smartengines/passport_engine.h"
+
+#include "BinaryResults.h"
+#include "DataDirectory.h"
+#include "JsonFiles.h"
+#include "JsonLines.h"
+#include "ResultReporter.h"
+#include "jsoncons/arena_allocator.hpp"
+#include "jsoncons/fd_sink.hpp"
+#include "jsoncons/json_path_extractor.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	std::atomic<unsigned long long> allocation_count(0);
+	std::atomic<unsigned long long> allocated_bytes(0);
+}
+
+void *operator new(size_t size)
+{
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+	if (void *p = malloc(size ? size : 1))
+	{
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+	free(p);
+}
+
+struct BenchmarkOptions
+{
+	size_t images = 1000;
+	int repetitions = 10;
+	int warmup = 2;
+	std::string filter;
+	std::string work_dir = "driver_benchmark";
+	bool json_output = false;
+};
+
+struct BenchmarkResult
+{
+	std::string name;
+	std::vector<double> ns_per_image;
+	double allocations_per_image = 0;
+	double bytes_per_image = 0;
+};
+
+// Runs prepare() and then the timed run() warmup + repetitions times
+BenchmarkResult Measure(const std::string &name, const BenchmarkOptions &options, size_t images, std::function<void()> prepare, std::function<void()> run)
+{
+	BenchmarkResult result;
+	result.name = name;
+
+	unsigned long long allocations = 0, bytes = 0;
+	for (int repetition = 0; repetition < options.warmup + options.repetitions; ++repetition)
+	{
+		prepare();
+
+		unsigned long long allocations_before = allocation_count.load();
+		unsigned long long bytes_before = allocated_bytes.load();
+		auto start = std::chrono::steady_clock::now();
+
+		run();
+
+		auto stop = std::chrono::steady_clock::now();
+		if (repetition < options.warmup)
+		{
+			continue;
+		}
+
+		allocations += allocation_count.load() - allocations_before;
+		bytes += allocated_bytes.load() - bytes_before;
+		result.ns_per_image.push_back(std::chrono::duration<double, std::nano>(stop - start).count() / images);
+	}
+
+	double measured_images = static_cast<double>(images) * options.repetitions;
+	result.allocations_per_image = allocations / measured_images;
+	result.bytes_per_image = bytes / measured_images;
+	return result;
+}
+
+void PrintResult(const BenchmarkResult &result, const BenchmarkOptions &options)
+{
+	std::vector<double> sorted = result.ns_per_image;
+	std::sort(sorted.begin(), sorted.end());
+
+	double mean = 0;
+	for (double value : sorted)
+	{
+		mean += value;
+	}
+	mean /= sorted.size();
+	double median = sorted.size() % 2 ? sorted[sorted.size() / 2] : (sorted[sorted.size() / 2 - 1] + sorted[sorted.size() / 2]) / 2;
+
+	if (options.json_output)
+	{
+		json ns_per_image;
+		ns_per_image["min"] = sorted.front();
+		ns_per_image["median"] = median;
+		ns_per_image["mean"] = mean;
+		ns_per_image["max"] = sorted.back();
+
+		json record;
+		record["benchmark"] = result.name;
+		record["images"] = static_cast<uint64_t>(options.images);
+		record["repetitions"] = options.repetitions;
+		record["ns_per_image"] = ns_per_image;
+		record["allocations_per_image"] = result.allocations_per_image;
+		record["bytes_per_image"] = result.bytes_per_image;
+		std::cout << record.as_string() << std::endl;
+		return;
+	}
+
+	char line[256];
+	snprintf(line, sizeof(line), "%-20s %12.0f %14.0f %12.0f %11.1f %11.0f",
+		result.name.c_str(), sorted.front(), median, sorted.back(), result.allocations_per_image, result.bytes_per_image);
+	std::cout << line << std::endl;
+}
+
+// Keeps what the stand-in engine reports, to feed the callbacks under test
+struct CapturingReporter : PassportResultReporterInterface
+{
+	PassportMatchResult match;
+	PassportRecognitionResult result;
+
+	virtual void DocumentMatched(const PassportMatchResult &match_result, PassportImageRequest &request) override
+	{
+		match = match_result;
+	}
+
+	virtual void SnapshotProcessed(const PassportRecognitionResult &recognition_result, bool may_finish, bool is_break) override
+	{
+		result = recognition_result;
+	}
+};
+
+BenchmarkOptions ParseOptions(int argc, char **argv)
+{
+	BenchmarkOptions options;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--images" && i + 1 < argc)
+		{
+			options.images = std::max(1, atoi(argv[++i]));
+		}
+		else if (arg == "--repetitions" && i + 1 < argc)
+		{
+			options.repetitions = std::max(1, atoi(argv[++i]));
+		}
+		else if (arg == "--warmup" && i + 1 < argc)
+		{
+			options.warmup = std::max(0, atoi(argv[++i]));
+		}
+		else if (arg == "--filter" && i + 1 < argc)
+		{
+			options.filter = argv[++i];
+		}
+		else if (arg == "--work-dir" && i + 1 < argc)
+		{
+			options.work_dir = argv[++i];
+		}
+		else if (arg == "--format" && i + 1 < argc)
+		{
+			options.json_output = std::string(argv[++i]) == "json";
+		}
+	}
+	return options;
+}
+
+int main(int argc, char **argv)
+{
+	BenchmarkOptions options = ParseOptions(argc, argv);
+
+	// Data set: packs of up to 100 empty images, and matching result directories
+	std::string data_dir = options.work_dir + "/data";
+	std::string result_dir = options.work_dir + "/result";
+	MakeDirectory(options.work_dir);
+	MakeDirectory(data_dir);
+	MakeDirectory(result_dir);
+
+	std::vector<ImageTask> tasks;
+	for (size_t i = 0; i < options.images; ++i)
+	{
+		std::string pack = "pack" + std::to_string(i / 100);
+		std::string name = std::to_string(i) + ".jpg";
+		if (i % 100 == 0)
+		{
+			MakeDirectory(data_dir + "/" + pack);
+			MakeDirectory(result_dir + "/" + pack);
+		}
+
+		ImageTask task;
+		task.relative_path = pack + "/" + name;
+		task.image_path = data_dir + "/" + task.relative_path;
+		task.result_file_path = result_dir + "/" + task.relative_path + ".json";
+		std::ofstream(task.image_path.c_str());
+		tasks.push_back(task);
+	}
+
+	std::string config_path = options.work_dir + "/standin.json";
+	std::ofstream(config_path.c_str()) << "{}";
+
+	PassportEngine engine;
+	std::vector<CapturingReporter> recognized(tasks.size());
+	try {
+		engine.Configure(config_path);
+		for (size_t i = 0; i < tasks.size(); ++i)
+		{
+			engine.InitializeSession(recognized[i]);
+			engine.ProcessImageFile(tasks[i].image_path);
+			engine.TerminateSession();
+		}
+	}
+	catch (const PassportException &e) {
+		std::cout << "Exception: " << e.what() << std::endl;
+		return 1;
+	}
+
+	if (!options.json_output)
+	{
+		std::cout << "Images: " << options.images << ", repetitions: " << options.repetitions << ", warm-up: " << options.warmup << std::endl;
+		std::cout << std::endl;
+		char header[256];
+		snprintf(header, sizeof(header), "%-20s %12s %14s %12s %11s %11s", "benchmark", "min ns/img", "median ns/img", "max ns/img", "allocs/img", "bytes/img");
+		std::cout << header << std::endl;
+	}
+
+	size_t count = tasks.size();
+	std::vector<std::unique_ptr<ResultReporter>> reporters;
+
+	auto benchmark = [&](const std::string &name, size_t images, std::function<void()> prepare, std::function<void()> run)
+	{
+		if (name.find(options.filter) != std::string::npos)
+		{
+			PrintResult(Measure(name, options, images, prepare, run), options);
+		}
+	};
+
+	auto fresh_reporters = [&]()
+	{
+		reporters.clear();
+		for (size_t i = 0; i < count; ++i)
+		{
+			reporters.emplace_back(new ResultReporter(&engine, tasks[i].image_path));
+		}
+	};
+
+	auto reported_results = [&]()
+	{
+		fresh_reporters();
+		for (size_t i = 0; i < count; ++i)
+		{
+			PassportImageRequest request;
+			reporters[i]->DocumentMatched(recognized[i].match, request);
+			reporters[i]->SnapshotProcessed(recognized[i].result, true, false);
+		}
+	};
+
+	benchmark("snapshot_processed", count,
+		fresh_reporters,
+		[&]()
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				reporters[i]->SnapshotProcessed(recognized[i].result, true, false);
+			}
+		});
+
+	// Serializer events of the result members, into memory
+	std::ostringstream stream;
+	benchmark("serialize_result", count,
+		[&]()
+		{
+			reported_results();
+			stream.str(std::string());
+		},
+		[&]()
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				json_serializer serializer(stream);
+				serializer.begin_json();
+				serializer.begin_object();
+				reporters[i]->result.WriteMembers(serializer);
+				serializer.end_object();
+				serializer.end_json();
+			}
+		});
+
+	// A number-heavy report: the timing object of every result, with phase
+	// times that need all 17 digits
+	auto timed_results = [&]()
+	{
+		reported_results();
+		for (size_t i = 0; i < count; ++i)
+		{
+			ResultTiming &timing = reporters[i]->result.timing;
+			PhaseTime *phases[] = { &timing.initialize_session, &timing.process_image, &timing.terminate_session, &timing.build_json, &timing.write_file };
+			for (size_t j = 0; j < 5; ++j)
+			{
+				phases[j]->wall_ms = (i % 97 + j + 1) / 7.0;
+				phases[j]->cpu_ms = (i % 89 + j + 1) / 13.0;
+			}
+		}
+	};
+
+	benchmark("serialize_timing", count,
+		[&]()
+		{
+			timed_results();
+			stream.str(std::string());
+		},
+		[&]()
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				json_serializer serializer(stream);
+				serializer.begin_json();
+				reporters[i]->result.timing.Write(serializer);
+				serializer.end_json();
+			}
+		});
+
+	// Reading those timing objects back
+	std::vector<std::string> timing_texts;
+	double timing_total = 0;
+	benchmark("parse_timing", count,
+		[&]()
+		{
+			timed_results();
+			timing_texts.clear();
+			timing_total = 0;
+			for (size_t i = 0; i < count; ++i)
+			{
+				std::ostringstream text;
+				{
+					json_serializer serializer(text);
+					serializer.begin_json();
+					reporters[i]->result.timing.Write(serializer);
+					serializer.end_json();
+				}
+				timing_texts.push_back(text.str());
+			}
+		},
+		[&]()
+		{
+			for (const std::string &text : timing_texts)
+			{
+				json timing = json::parse_string(text);
+				timing_total += timing["process_image"]["wall_ms"].as_double();
+			}
+		});
+
+	// The parser alone over whole result records, without building a tree
+	std::vector<std::string> result_texts;
+	benchmark("parse_result_text", count,
+		[&]()
+		{
+			reported_results();
+			result_texts.clear();
+			for (size_t i = 0; i < count; ++i)
+			{
+				std::ostringstream text;
+				WriteResultRecord(text, reporters[i]->result);
+				result_texts.push_back(text.str());
+			}
+		},
+		[&]()
+		{
+			for (const std::string &text : result_texts)
+			{
+				jsoncons::json_parser parser(jsoncons::empty_json_input_handler::instance());
+				parser.begin_parse();
+				parser.parse(text.data(), 0, text.size());
+				parser.end_parse();
+			}
+		});
+
+	// Building the "data" object of a result as a json tree, one set per
+	// member against one sorted bulk insert
+	std::vector<json> trees;
+	auto field_json = [](bool accepted, const std::string &value)
+	{
+		std::vector<json::member_type> members;
+		members.emplace_back("confidence", json(accepted ? "1" : "0"));
+		members.emplace_back("value", json(value));
+
+		json field;
+		field.insert_members(jsoncons::sorted_unique_range_tag(), std::make_move_iterator(members.begin()), std::make_move_iterator(members.end()));
+		return field;
+	};
+
+	benchmark("build_json_set", count,
+		[&]() { trees.clear(); trees.reserve(count); },
+		[&]()
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				json data;
+				ForEachPassportField([&](auto, const auto &info)
+				{
+					const auto &field = info.Of(recognized[i].result);
+					json value;
+					value.set("confidence", json(field.is_accepted ? "1" : "0"));
+					value.set("value", json(PassportFieldText<typename std::decay<decltype(field)>::type>::Get(field)));
+					data.set(std::string(info.name, info.name_length), std::move(value));
+				});
+				trees.push_back(std::move(data));
+			}
+		});
+
+	benchmark("build_json_bulk", count,
+		[&]() { trees.clear(); trees.reserve(count); },
+		[&]()
+		{
+			std::vector<json::member_type> members;
+			for (size_t i = 0; i < count; ++i)
+			{
+				members.clear();
+				ForEachPassportField([&](auto, const auto &info)
+				{
+					const auto &field = info.Of(recognized[i].result);
+					members.emplace_back(std::string(info.name, info.name_length),
+						field_json(field.is_accepted, PassportFieldText<typename std::decay<decltype(field)>::type>::Get(field)));
+				});
+
+				json data;
+				data.insert_members(jsoncons::sorted_unique_range_tag(), std::make_move_iterator(members.begin()), std::make_move_iterator(members.end()));
+				trees.push_back(std::move(data));
+			}
+		});
+
+	// The same bulk build with every node of the trees taken from a
+	// monotonic arena, which is released in one go between repetitions
+	typedef jsoncons::basic_json<char, jsoncons::arena_allocator<void>> arena_json;
+	jsoncons::monotonic_arena arena;
+	std::vector<arena_json> arena_trees;
+	auto arena_field_json = [](bool accepted, const std::string &value)
+	{
+		std::vector<arena_json::member_type> members;
+		members.emplace_back("confidence", arena_json(accepted ? "1" : "0"));
+		members.emplace_back("value", arena_json(value));
+
+		arena_json field;
+		field.insert_members(jsoncons::sorted_unique_range_tag(), std::make_move_iterator(members.begin()), std::make_move_iterator(members.end()));
+		return field;
+	};
+
+	benchmark("build_json_arena", count,
+		[&]()
+		{
+			{
+				jsoncons::arena_scope scope(arena);
+				arena_trees.clear();
+			}
+			arena.reset();
+			arena_trees.reserve(count);
+		},
+		[&]()
+		{
+			jsoncons::arena_scope scope(arena);
+			std::vector<arena_json::member_type> members;
+			for (size_t i = 0; i < count; ++i)
+			{
+				members.clear();
+				ForEachPassportField([&](auto, const auto &info)
+				{
+					const auto &field = info.Of(recognized[i].result);
+					members.emplace_back(std::string(info.name, info.name_length),
+						arena_field_json(field.is_accepted, PassportFieldText<typename std::decay<decltype(field)>::type>::Get(field)));
+				});
+
+				arena_json data;
+				data.insert_members(jsoncons::sorted_unique_range_tag(), std::make_move_iterator(members.begin()), std::make_move_iterator(members.end()));
+				arena_trees.push_back(std::move(data));
+			}
+		});
+
+	std::vector<ImageResult> results;
+	benchmark("write_result_file", count,
+		[&]()
+		{
+			reported_results();
+			results.clear();
+			for (size_t i = 0; i < count; ++i)
+			{
+				results.push_back(reporters[i]->result);
+			}
+		},
+		[&]()
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				WriteResultFile(tasks[i].result_file_path, results[i]);
+			}
+		});
+
+	// Same results as one JSON Lines file per pack, written in batches
+	benchmark("write_json_lines", count,
+		[&]()
+		{
+			reported_results();
+			results.clear();
+			for (size_t i = 0; i < count; ++i)
+			{
+				results.push_back(reporters[i]->result);
+			}
+		},
+		[&]()
+		{
+			JsonLinesWriter writer(result_dir, "", false);
+			auto complete = [](const std::string &) {};
+			auto failed = [](const std::string &) {};
+			for (size_t i = 0; i < count; ++i)
+			{
+				writer.Write(tasks[i].relative_path, results[i], complete, failed);
+			}
+			writer.Flush(complete, failed);
+		});
+
+	// All results as one large JSON array in a single file, through a
+	// std::ofstream and straight to the file descriptor
+	std::string stream_path = options.work_dir + "/results.json";
+	auto copied_results = [&]()
+	{
+		reported_results();
+		results.clear();
+		for (size_t i = 0; i < count; ++i)
+		{
+			results.push_back(reporters[i]->result);
+		}
+	};
+	auto write_results_array = [&](json_serializer &serializer)
+	{
+		serializer.begin_json();
+		serializer.begin_array();
+		for (size_t i = 0; i < count; ++i)
+		{
+			serializer.begin_object();
+			results[i].WriteMembers(serializer);
+			serializer.end_object();
+		}
+		serializer.end_array();
+		serializer.end_json();
+	};
+
+	benchmark("stream_results_ofstream", count,
+		copied_results,
+		[&]()
+		{
+			std::ofstream file(stream_path.c_str(), std::ios::binary | std::ios::trunc);
+			json_serializer serializer(file);
+			write_results_array(serializer);
+		});
+
+	benchmark("stream_results_fd", count,
+		copied_results,
+		[&]()
+		{
+			FILE *file = fopen(stream_path.c_str(), "wb");
+			{
+				jsoncons::fd_sink sink(fileno(file));
+				json_serializer serializer(sink, 64 * 1024, 4096);
+				write_results_array(serializer);
+			}
+			fclose(file);
+		});
+
+	// Same results in the binary format
+	benchmark("write_binary_results", count,
+		[&]()
+		{
+			reported_results();
+			results.clear();
+			for (size_t i = 0; i < count; ++i)
+			{
+				results.push_back(reporters[i]->result);
+			}
+		},
+		[&]()
+		{
+			BinaryResultsWriter writer(result_dir, "", false);
+			auto complete = [](const std::string &) {};
+			auto failed = [](const std::string &) {};
+			for (size_t i = 0; i < count; ++i)
+			{
+				writer.Write(tasks[i].relative_path, results[i], complete, failed);
+			}
+			writer.Flush(complete, failed);
+		});
+
+	// Reading results back for evaluation: one JSON file per image against
+	// the mapped binary pack files. Both count the accepted series fields.
+	{
+		reported_results();
+		BinaryResultsWriter writer(result_dir, "", false);
+		auto complete = [](const std::string &) {};
+		auto failed = [](const std::string &) {};
+		for (size_t i = 0; i < count; ++i)
+		{
+			WriteResultFile(tasks[i].result_file_path, reporters[i]->result);
+			writer.Write(tasks[i].relative_path, reporters[i]->result, complete, failed);
+		}
+		writer.Flush(complete, failed);
+	}
+
+	size_t accepted = 0;
+	benchmark("parse_result_files", count,
+		[&]() { accepted = 0; },
+		[&]()
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				json result = json::parse_file(tasks[i].result_file_path);
+				accepted += result["data"].get("series", json()).get("confidence", json("0")).as_string() == "1";
+			}
+		});
+
+	std::vector<std::string> result_paths;
+	for (size_t i = 0; i < count; ++i)
+	{
+		result_paths.push_back(tasks[i].result_file_path);
+	}
+	benchmark("load_result_files", count,
+		[&]() { accepted = 0; },
+		[&]()
+		{
+			LoadJsonFiles(result_paths,
+				[&](const std::string &, const json &result)
+				{
+					accepted += result["data"].get("series", json()).get("confidence", json("0")).as_string() == "1";
+				},
+				[](const std::string &) {});
+		});
+
+	// The fields the dashboard reads, without building the documents
+	jsoncons::json_path_extractor extractor;
+	size_t series_confidence = extractor.add_path("data.series.confidence");
+	extractor.add_path("data.series.value");
+	extractor.add_path("data.surname.value");
+	extractor.add_path("matches.length");
+	extractor.add_path("time");
+	benchmark("extract_result_fields", count,
+		[&]() { accepted = 0; },
+		[&]()
+		{
+			JsonFileParser parser;
+			for (const std::string &path : result_paths)
+			{
+				if (parser.Parse(path, extractor))
+				{
+					accepted += extractor[series_confidence].string_value == "1";
+				}
+			}
+		});
+
+	benchmark("read_binary_results", count,
+		[&]() { accepted = 0; },
+		[&]()
+		{
+			for (size_t pack = 0; pack * 100 < count; ++pack)
+			{
+				BinaryResultsFile results_file;
+				results_file.Open(BinaryResultsPath(result_dir, tasks[pack * 100].relative_path, ""));
+				for (size_t i = 0; i < results_file.Size(); ++i)
+				{
+					accepted += BinaryResultsFile::IsAccepted(results_file[i], binary_series);
+				}
+			}
+		});
+
+	// The work directory may still hold packs of an earlier, larger run
+	std::vector<ImageTask> enumerated;
+	EnumerateImages(data_dir, result_dir, false, [&](const ImageTask &task) { enumerated.push_back(task); });
+	benchmark("enumerate_images", enumerated.size(),
+		[&]()
+		{
+			size_t capacity = enumerated.size();
+			enumerated.clear();
+			enumerated.reserve(capacity);
+		},
+		[&]()
+		{
+			EnumerateImages(data_dir, result_dir, false, [&](const ImageTask &task) { enumerated.push_back(task); });
+		});
+
+	// Engine calls of ResultReporter::ProcessImage; includes the stand-in's own work
+	benchmark("process_image", count,
+		fresh_reporters,
+		[&]()
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				PrefetchedImage image;
+				reporters[i]->ProcessImage(image);
+			}
+		});
+
+	// Everything a worker does per image, except for the queue to the writer
+	benchmark("end_to_end", count,
+		[&]() { reporters.clear(); },
+		[&]()
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				ResultReporter reporter(&engine, tasks[i].image_path);
+				PrefetchedImage image;
+				reporter.ProcessImage(image);
+				WriteResultFile(tasks[i].result_file_path, reporter.result);
+			}
+		});
+
+	return 0;
+}
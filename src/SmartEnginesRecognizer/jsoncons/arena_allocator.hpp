@@ -0,0 +1,245 @@
+// Copyright 2013 Daniel Parker
+// Distributed under the Boost license, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// See https://sourceforge.net/projects/jsoncons/files/ for latest version
+// See https://sourceforge.net/p/jsoncons/wiki/Home/ for documentation.
+
+#ifndef JSONCONS_ARENA_ALLOCATOR_HPP
+#define JSONCONS_ARENA_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace jsoncons {
+
+// Monotonic arena: allocation bumps a pointer through a list of blocks that
+// double in size, deallocation does nothing. Everything is released at once
+// by reset() or by destroying the arena.
+class monotonic_arena
+{
+public:
+    static const size_t default_block_size = 64*1024;
+
+    explicit monotonic_arena(size_t initial_block_size = default_block_size)
+        : next_block_size_(initial_block_size > 0 ? initial_block_size : default_block_size),
+          current_(nullptr), end_(nullptr), bytes_allocated_(0)
+    {
+    }
+
+    ~monotonic_arena()
+    {
+        for (size_t i = 0; i < blocks_.size(); ++i)
+        {
+            std::free(blocks_[i].data);
+        }
+    }
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+    {
+        // Padding and size are checked against the room left without forming
+        // a pointer past the block, which a large alignment could do
+        size_t padding = padding_for(current_, alignment);
+        size_t room = current_ == nullptr ? 0 : static_cast<size_t>(end_ - current_);
+        if (current_ == nullptr || room < padding || room - padding < size)
+        {
+            add_block(size + alignment);
+            padding = padding_for(current_, alignment);
+        }
+        char* p = current_ + padding;
+        current_ = p + size;
+        bytes_allocated_ += size;
+        return p;
+    }
+
+    // Releases everything allocated so far. The largest block is kept for
+    // reuse, the others are freed.
+    void reset()
+    {
+        if (blocks_.empty())
+        {
+            return;
+        }
+        size_t largest = 0;
+        for (size_t i = 1; i < blocks_.size(); ++i)
+        {
+            if (blocks_[i].size > blocks_[largest].size)
+            {
+                largest = i;
+            }
+        }
+        for (size_t i = 0; i < blocks_.size(); ++i)
+        {
+            if (i != largest)
+            {
+                std::free(blocks_[i].data);
+            }
+        }
+        block kept = blocks_[largest];
+        blocks_.clear();
+        blocks_.push_back(kept);
+        current_ = kept.data;
+        end_ = kept.data + kept.size;
+        bytes_allocated_ = 0;
+    }
+
+    size_t bytes_allocated() const
+    {
+        return bytes_allocated_;
+    }
+
+    // The arena arena_allocator draws from on this thread, set by arena_scope
+    static monotonic_arena*& current()
+    {
+        static thread_local monotonic_arena* arena = nullptr;
+        return arena;
+    }
+private:
+    monotonic_arena(const monotonic_arena&) = delete;
+    monotonic_arena& operator=(const monotonic_arena&) = delete;
+
+    struct block
+    {
+        char* data;
+        size_t size;
+    };
+
+    // Bytes to skip from p to the next multiple of alignment
+    static size_t padding_for(const char* p, size_t alignment)
+    {
+        size_t offset = reinterpret_cast<uintptr_t>(p) % alignment;
+        return offset == 0 ? 0 : alignment - offset;
+    }
+
+    void add_block(size_t min_size)
+    {
+        size_t size = next_block_size_;
+        while (size < min_size)
+        {
+            size *= 2;
+        }
+        char* data = static_cast<char*>(std::malloc(size));
+        if (data == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        block b = {data, size};
+        blocks_.push_back(b);
+        current_ = data;
+        end_ = data + size;
+        next_block_size_ = size*2;
+    }
+
+    std::vector<block> blocks_;
+    size_t next_block_size_;
+    char* current_;
+    char* end_;
+    size_t bytes_allocated_;
+};
+
+// Makes an arena current on this thread for the lifetime of the scope
+class arena_scope
+{
+public:
+    explicit arena_scope(monotonic_arena& arena)
+        : previous_(monotonic_arena::current())
+    {
+        monotonic_arena::current() = &arena;
+    }
+
+    ~arena_scope()
+    {
+        monotonic_arena::current() = previous_;
+    }
+private:
+    arena_scope(const arena_scope&) = delete;
+    arena_scope& operator=(const arena_scope&) = delete;
+
+    monotonic_arena* previous_;
+};
+
+// Stateless allocator over the current monotonic_arena, for use as the
+// Alloc parameter of basic_json. Values must be created while an arena is
+// current and must not be used after that arena is reset or destroyed.
+template <class T>
+class arena_allocator
+{
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template <class U>
+    struct rebind
+    {
+        typedef arena_allocator<U> other;
+    };
+
+    arena_allocator()
+    {
+    }
+
+    template <class U>
+    arena_allocator(const arena_allocator<U>&)
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        monotonic_arena* arena = monotonic_arena::current();
+        if (arena == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(arena->allocate(n*sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t)
+    {
+    }
+
+    friend bool operator==(const arena_allocator&, const arena_allocator&)
+    {
+        return true;
+    }
+
+    friend bool operator!=(const arena_allocator&, const arena_allocator&)
+    {
+        return false;
+    }
+};
+
+template <>
+class arena_allocator<void>
+{
+public:
+    typedef void value_type;
+    typedef void* pointer;
+    typedef const void* const_pointer;
+
+    template <class U>
+    struct rebind
+    {
+        typedef arena_allocator<U> other;
+    };
+
+    arena_allocator()
+    {
+    }
+
+    template <class U>
+    arena_allocator(const arena_allocator<U>&)
+    {
+    }
+};
+
+}
+
+#endif
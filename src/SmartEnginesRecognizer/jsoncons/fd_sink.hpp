@@ -0,0 +1,128 @@
+// Copyright 2013 Daniel Parker
+// Distributed under the Boost license, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// See https://sourceforge.net/projects/jsoncons/files/ for latest version
+// See https://sourceforge.net/p/jsoncons/wiki/Home/ for documentation.
+
+#ifndef JSONCONS_FD_SINK_HPP
+#define JSONCONS_FD_SINK_HPP
+
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <system_error>
+#include "jsoncons/jsoncons.hpp"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace jsoncons {
+
+// Sink that writes straight to a file descriptor it does not own, without a
+// stream in between. The two-piece write of a full buffer and the text that
+// did not fit is a single writev. flush() does nothing unless sync_on_flush
+// is set, in which case it waits for the data to reach the disk. Write
+// errors throw std::system_error.
+class fd_sink : public basic_output_sink<char>
+{
+    int fd_;
+    bool sync_on_flush_;
+public:
+    explicit fd_sink(int fd, bool sync_on_flush = false)
+        : fd_(fd), sync_on_flush_(sync_on_flush)
+    {
+    }
+
+    int fd() const
+    {
+        return fd_;
+    }
+
+    void write(const char* s, size_t length) override
+    {
+        while (length > 0)
+        {
+#ifdef _WIN32
+            int written = ::_write(fd_, s, static_cast<unsigned int>(length < INT_MAX ? length : INT_MAX));
+#else
+            ssize_t written = ::write(fd_, s, length);
+#endif
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "write");
+            }
+            s += written;
+            length -= static_cast<size_t>(written);
+        }
+    }
+
+    void write(const char* s1, size_t length1, const char* s2, size_t length2) override
+    {
+#ifdef _WIN32
+        write(s1, length1);
+        write(s2, length2);
+#else
+        while (length1 > 0)
+        {
+            struct iovec pieces[2];
+            pieces[0].iov_base = const_cast<char*>(s1);
+            pieces[0].iov_len = length1;
+            pieces[1].iov_base = const_cast<char*>(s2);
+            pieces[1].iov_len = length2;
+            ssize_t written = ::writev(fd_, pieces, 2);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "writev");
+            }
+
+            size_t n = static_cast<size_t>(written);
+            if (n >= length1)
+            {
+                s2 += n - length1;
+                length2 -= n - length1;
+                length1 = 0;
+            }
+            else
+            {
+                s1 += n;
+                length1 -= n;
+            }
+        }
+        write(s2, length2);
+#endif
+    }
+
+    void flush() override
+    {
+        if (!sync_on_flush_)
+        {
+            return;
+        }
+#ifdef _WIN32
+        int result = ::_commit(fd_);
+#else
+        int result = ::fsync(fd_);
+#endif
+        if (result != 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "fsync");
+        }
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,324 @@
+// Copyright 2013 Daniel Parker
+// Distributed under the Boost license, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// See https://sourceforge.net/projects/jsoncons/files/ for latest version
+// See https://sourceforge.net/p/jsoncons/wiki/Home/ for documentation.
+
+#ifndef JSONCONS_GRISU_HPP
+#define JSONCONS_GRISU_HPP
+
+#include <cstdint>
+#include <cstring>
+
+namespace jsoncons {
+
+// Shortest round-trip digits of a double with Grisu2 (Florian Loitsch,
+// "Printing Floating-Point Numbers Quickly and Accurately with Integers",
+// PLDI 2010). The digits always read back as the same double and are the
+// shortest such digits for all but a tiny fraction of inputs, where one more
+// digit is produced.
+
+namespace grisu {
+
+struct diy_fp
+{
+    uint64_t f;
+    int e;
+
+    diy_fp(uint64_t f_, int e_)
+        : f(f_), e(e_)
+    {
+    }
+};
+
+inline diy_fp subtract(const diy_fp& x, const diy_fp& y)
+{
+    return diy_fp(x.f - y.f, x.e);
+}
+
+// Upper 64 bits of the 128 bit product, rounded
+inline diy_fp multiply(const diy_fp& x, const diy_fp& y)
+{
+    const uint64_t mask32 = 0xFFFFFFFFu;
+
+    uint64_t u_lo = x.f & mask32;
+    uint64_t u_hi = x.f >> 32;
+    uint64_t v_lo = y.f & mask32;
+    uint64_t v_hi = y.f >> 32;
+
+    uint64_t p0 = u_lo*v_lo;
+    uint64_t p1 = u_lo*v_hi;
+    uint64_t p2 = u_hi*v_lo;
+    uint64_t p3 = u_hi*v_hi;
+
+    uint64_t q = (p0 >> 32) + (p1 & mask32) + (p2 & mask32) + (uint64_t(1) << 31);
+    uint64_t h = p3 + (p1 >> 32) + (p2 >> 32) + (q >> 32);
+
+    return diy_fp(h, x.e + y.e + 64);
+}
+
+inline diy_fp normalize(diy_fp x)
+{
+    for (int shift = 32; shift > 0; shift /= 2)
+    {
+        if ((x.f >> (64 - shift)) == 0)
+        {
+            x.f <<= shift;
+            x.e -= shift;
+        }
+    }
+    return x;
+}
+
+inline diy_fp normalize_to(const diy_fp& x, int e)
+{
+    return diy_fp(x.f << (x.e - e), e);
+}
+
+// v and the boundaries m- and m+ of the interval of reals that round to v,
+// with m+ normalized and m- scaled to the same exponent
+struct boundaries
+{
+    diy_fp w;
+    diy_fp minus;
+    diy_fp plus;
+};
+
+inline boundaries compute_boundaries(double value)
+{
+    const int significand_bits = 52;
+    const int exponent_bias = 1023 + significand_bits;
+    const uint64_t hidden_bit = uint64_t(1) << significand_bits;
+
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint64_t biased_e = (bits >> significand_bits) & 0x7FF;
+    uint64_t fraction = bits & (hidden_bit - 1);
+
+    diy_fp v = biased_e == 0
+        ? diy_fp(fraction, 1 - exponent_bias)
+        : diy_fp(fraction + hidden_bit, static_cast<int>(biased_e) - exponent_bias);
+
+    // The gap below v is half as wide when v is a power of two
+    bool lower_boundary_is_closer = fraction == 0 && biased_e > 1;
+    diy_fp m_plus(2*v.f + 1, v.e - 1);
+    diy_fp m_minus = lower_boundary_is_closer
+        ? diy_fp(4*v.f - 1, v.e - 2)
+        : diy_fp(2*v.f - 1, v.e - 1);
+
+    diy_fp w_plus = normalize(m_plus);
+    boundaries b = {normalize(v), normalize_to(m_minus, w_plus.e), w_plus};
+    return b;
+}
+
+struct cached_power
+{
+    uint64_t f;
+    int e;
+    int k;
+};
+
+// Target range of the binary exponent of w scaled by the cached power
+const int min_target_exponent = -60;
+const int max_target_exponent = -32;
+
+inline cached_power get_cached_power(int e)
+{
+    // Normalized 10^k for k = -300, -292, ..., 324, rounded to 64 bits
+    static const cached_power powers[] =
+    {
+        { 0xAB70FE17C79AC6CA, -1060, -300 },
+        { 0xFF77B1FCBEBCDC4F, -1034, -292 },
+        { 0xBE5691EF416BD60C, -1007, -284 },
+        { 0x8DD01FAD907FFC3C,  -980, -276 },
+        { 0xD3515C2831559A83,  -954, -268 },
+        { 0x9D71AC8FADA6C9B5,  -927, -260 },
+        { 0xEA9C227723EE8BCB,  -901, -252 },
+        { 0xAECC49914078536D,  -874, -244 },
+        { 0x823C12795DB6CE57,  -847, -236 },
+        { 0xC21094364DFB5637,  -821, -228 },
+        { 0x9096EA6F3848984F,  -794, -220 },
+        { 0xD77485CB25823AC7,  -768, -212 },
+        { 0xA086CFCD97BF97F4,  -741, -204 },
+        { 0xEF340A98172AACE5,  -715, -196 },
+        { 0xB23867FB2A35B28E,  -688, -188 },
+        { 0x84C8D4DFD2C63F3B,  -661, -180 },
+        { 0xC5DD44271AD3CDBA,  -635, -172 },
+        { 0x936B9FCEBB25C996,  -608, -164 },
+        { 0xDBAC6C247D62A584,  -582, -156 },
+        { 0xA3AB66580D5FDAF6,  -555, -148 },
+        { 0xF3E2F893DEC3F126,  -529, -140 },
+        { 0xB5B5ADA8AAFF80B8,  -502, -132 },
+        { 0x87625F056C7C4A8B,  -475, -124 },
+        { 0xC9BCFF6034C13053,  -449, -116 },
+        { 0x964E858C91BA2655,  -422, -108 },
+        { 0xDFF9772470297EBD,  -396, -100 },
+        { 0xA6DFBD9FB8E5B88F,  -369,  -92 },
+        { 0xF8A95FCF88747D94,  -343,  -84 },
+        { 0xB94470938FA89BCF,  -316,  -76 },
+        { 0x8A08F0F8BF0F156B,  -289,  -68 },
+        { 0xCDB02555653131B6,  -263,  -60 },
+        { 0x993FE2C6D07B7FAC,  -236,  -52 },
+        { 0xE45C10C42A2B3B06,  -210,  -44 },
+        { 0xAA242499697392D3,  -183,  -36 },
+        { 0xFD87B5F28300CA0E,  -157,  -28 },
+        { 0xBCE5086492111AEB,  -130,  -20 },
+        { 0x8CBCCC096F5088CC,  -103,  -12 },
+        { 0xD1B71758E219652C,   -77,   -4 },
+        { 0x9C40000000000000,   -50,    4 },
+        { 0xE8D4A51000000000,   -24,   12 },
+        { 0xAD78EBC5AC620000,     3,   20 },
+        { 0x813F3978F8940984,    30,   28 },
+        { 0xC097CE7BC90715B3,    56,   36 },
+        { 0x8F7E32CE7BEA5C70,    83,   44 },
+        { 0xD5D238A4ABE98068,   109,   52 },
+        { 0x9F4F2726179A2245,   136,   60 },
+        { 0xED63A231D4C4FB27,   162,   68 },
+        { 0xB0DE65388CC8ADA8,   189,   76 },
+        { 0x83C7088E1AAB65DB,   216,   84 },
+        { 0xC45D1DF942711D9A,   242,   92 },
+        { 0x924D692CA61BE758,   269,  100 },
+        { 0xDA01EE641A708DEA,   295,  108 },
+        { 0xA26DA3999AEF774A,   322,  116 },
+        { 0xF209787BB47D6B85,   348,  124 },
+        { 0xB454E4A179DD1877,   375,  132 },
+        { 0x865B86925B9BC5C2,   402,  140 },
+        { 0xC83553C5C8965D3D,   428,  148 },
+        { 0x952AB45CFA97A0B3,   455,  156 },
+        { 0xDE469FBD99A05FE3,   481,  164 },
+        { 0xA59BC234DB398C25,   508,  172 },
+        { 0xF6C69A72A3989F5C,   534,  180 },
+        { 0xB7DCBF5354E9BECE,   561,  188 },
+        { 0x88FCF317F22241E2,   588,  196 },
+        { 0xCC20CE9BD35C78A5,   614,  204 },
+        { 0x98165AF37B2153DF,   641,  212 },
+        { 0xE2A0B5DC971F303A,   667,  220 },
+        { 0xA8D9D1535CE3B396,   694,  228 },
+        { 0xFB9B7CD9A4A7443C,   720,  236 },
+        { 0xBB764C4CA7A44410,   747,  244 },
+        { 0x8BAB8EEFB6409C1A,   774,  252 },
+        { 0xD01FEF10A657842C,   800,  260 },
+        { 0x9B10A4E5E9913129,   827,  268 },
+        { 0xE7109BFBA19C0C9D,   853,  276 },
+        { 0xAC2820D9623BF429,   880,  284 },
+        { 0x80444B5E7AA7CF85,   907,  292 },
+        { 0xBF21E44003ACDD2D,   933,  300 },
+        { 0x8E679C2F5E44FF8F,   960,  308 },
+        { 0xD433179D9C8CB841,   986,  316 },
+        { 0x9E19DB92B4E31BA9,  1013,  324 }
+    };
+    const int min_decimal_exponent = -300;
+    const int decimal_exponent_step = 8;
+
+    // ceil((min_target_exponent - e - 1) * log10(2))
+    int f = min_target_exponent - e - 1;
+    int k = (f*78913)/(1 << 18) + (f > 0);
+    int index = (-min_decimal_exponent + k + (decimal_exponent_step - 1))/decimal_exponent_step;
+    return powers[index];
+}
+
+// Largest power of ten not above n, with its number of digits
+inline int find_largest_pow10(uint32_t n, uint32_t& pow10)
+{
+    static const uint32_t powers[] =
+    {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+    };
+    int digits = 10;
+    while (digits > 1 && n < powers[digits - 1])
+    {
+        --digits;
+    }
+    pow10 = powers[digits - 1];
+    return digits;
+}
+
+// Moves the last digit towards w while that keeps it in range and closer
+inline void round_weed(char* buffer, int length, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t ten_k)
+{
+    while (rest < dist && delta - rest >= ten_k &&
+           (rest + ten_k < dist || dist - rest > rest + ten_k - dist))
+    {
+        --buffer[length - 1];
+        rest += ten_k;
+    }
+}
+
+inline void digit_gen(char* buffer, int& length, int& decimal_exponent,
+                      const diy_fp& m_minus, const diy_fp& w, const diy_fp& m_plus)
+{
+    uint64_t delta = subtract(m_plus, m_minus).f;
+    uint64_t dist = subtract(m_plus, w).f;
+
+    // m+ split into integral part p1 and fractional part p2
+    const int shift = -m_plus.e;
+    const uint64_t one = uint64_t(1) << shift;
+    uint32_t p1 = static_cast<uint32_t>(m_plus.f >> shift);
+    uint64_t p2 = m_plus.f & (one - 1);
+
+    uint32_t pow10;
+    int n = find_largest_pow10(p1, pow10);
+    while (n > 0)
+    {
+        uint32_t d = p1/pow10;
+        p1 %= pow10;
+        buffer[length++] = static_cast<char>('0' + d);
+        --n;
+
+        uint64_t rest = (uint64_t(p1) << shift) + p2;
+        if (rest <= delta)
+        {
+            decimal_exponent += n;
+            round_weed(buffer, length, dist, delta, rest, uint64_t(pow10) << shift);
+            return;
+        }
+        pow10 /= 10;
+    }
+
+    int m = 0;
+    for (;;)
+    {
+        p2 *= 10;
+        buffer[length++] = static_cast<char>('0' + (p2 >> shift));
+        p2 &= one - 1;
+        ++m;
+
+        delta *= 10;
+        dist *= 10;
+        if (p2 <= delta)
+        {
+            break;
+        }
+    }
+    decimal_exponent -= m;
+    round_weed(buffer, length, dist, delta, p2, one);
+}
+
+}
+
+// Digits of a finite value > 0 such that value = digits * 10^exponent.
+// buffer needs room for 17 characters.
+inline void grisu2(double value, char* buffer, int& length, int& exponent)
+{
+    grisu::boundaries b = grisu::compute_boundaries(value);
+    grisu::cached_power cached = grisu::get_cached_power(b.plus.e);
+    grisu::diy_fp c_minus_k(cached.f, cached.e);
+
+    grisu::diy_fp w = grisu::multiply(b.w, c_minus_k);
+    grisu::diy_fp w_minus = grisu::multiply(b.minus, c_minus_k);
+    grisu::diy_fp w_plus = grisu::multiply(b.plus, c_minus_k);
+
+    // Shrink the interval by one unit on each side to stay safe against the
+    // rounding in multiply
+    grisu::diy_fp m_minus(w_minus.f + 1, w_minus.e);
+    grisu::diy_fp m_plus(w_plus.f - 1, w_plus.e);
+
+    length = 0;
+    exponent = -cached.k;
+    grisu::digit_gen(buffer, length, exponent, m_minus, w, m_plus);
+}
+
+}
+
+#endif
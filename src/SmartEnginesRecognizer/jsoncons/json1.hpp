@@ -116,13 +116,20 @@ public:
         }
         ~any()
         {
-            delete impl_;
+            if (impl_ != nullptr)
+            {
+                impl_->destroy();
+            }
         }
 
+        // Allocation
+        static void* operator new(std::size_t) { return typename Alloc::template rebind<any>::other().allocate(1); }
+        static void operator delete(void* ptr) { return typename Alloc::template rebind<any>::other().deallocate(static_cast<any*>(ptr), 1); }
+
         template<typename T>
         explicit any(T val)
         {
-            impl_ = new any_handle_impl<typename type_wrapper<T>::value_type>(val);
+            impl_ = any_handle_impl<typename type_wrapper<T>::value_type>::make(val);
         }
 
         template <typename T>
@@ -165,6 +172,9 @@ public:
 
             virtual any_handle* clone() const = 0;
 
+            // Destroys and deallocates the handle through Alloc
+            virtual void destroy() = 0;
+
             virtual void to_stream(basic_json_output_handler<Char>& os) const = 0;
         };
 
@@ -172,14 +182,39 @@ public:
         class any_handle_impl : public any_handle
         {
         public:
+            typedef typename Alloc::template rebind<any_handle_impl>::other allocator_type;
+
             any_handle_impl(T value)
                 : value_(value)
             {
             }
 
+            static any_handle_impl* make(const T& value)
+            {
+                allocator_type alloc;
+                any_handle_impl* p = alloc.allocate(1);
+                try
+                {
+                    ::new(p) any_handle_impl(value);
+                }
+                catch (...)
+                {
+                    alloc.deallocate(p, 1);
+                    throw;
+                }
+                return p;
+            }
+
             virtual any_handle* clone() const
             {
-                return new any_handle_impl<T>(value_);
+                return make(value_);
+            }
+
+            virtual void destroy()
+            {
+                allocator_type alloc;
+                this->~any_handle_impl();
+                alloc.deallocate(this, 1);
             }
 
             virtual void to_stream(basic_json_output_handler<Char>& os) const
@@ -222,33 +257,31 @@ public:
         	Char c[1];
         };
 
-        static string_data* make_string_data()
+        typedef typename std::aligned_storage<sizeof(string_dataA), JSONCONS_ALIGNOF(string_dataA)>::type string_storage_type;
+        typedef typename Alloc::template rebind<string_storage_type>::other string_allocator_type;
 
+        // The header and the characters share one block of whole storage units
+        static size_t string_storage_count(size_t length)
         {
-            size_t length = 0;
-            typedef typename std::aligned_storage<sizeof(string_dataA), JSONCONS_ALIGNOF(string_dataA)>::type storage_type;
-
-            char* storage = new char[sizeof(storage_type) + length*sizeof(Char)];
-            string_data* ps = new(storage)string_data();
-            auto psa = reinterpret_cast<string_dataA*>(storage); 
+            return 1 + (length*sizeof(Char) + sizeof(string_storage_type) - 1)/sizeof(string_storage_type);
+        }
 
-            ps->p = new(&psa->c)Char[length + 1];
-            ps->p[length] = 0;
-            ps->length_ = length;
-            return ps;
+        static string_data* make_string_data()
+        {
+            return make_string_data(nullptr, 0);
         }
 
         static string_data* make_string_data(const Char* s, size_t length)
-
         {
-            typedef typename std::aligned_storage<sizeof(string_dataA), JSONCONS_ALIGNOF(string_dataA)>::type storage_type;
-
-            char* storage = new char[sizeof(storage_type) + length*sizeof(Char)];
+            string_storage_type* storage = string_allocator_type().allocate(string_storage_count(length));
             string_data* ps = new(storage)string_data();
             auto psa = reinterpret_cast<string_dataA*>(storage); 
 
             ps->p = new(&psa->c)Char[length + 1];
-            memcpy(ps->p, s, length*sizeof(Char));
+            if (length > 0)
+            {
+                memcpy(ps->p, s, length*sizeof(Char));
+            }
             ps->p[length] = 0;
             ps->length_ = length;
             return ps;
@@ -256,10 +289,15 @@ public:
 
         static void destroy_string_data(string_data* p)
         {
-            ::operator delete(reinterpret_cast<void*>(p));
+            size_t count = string_storage_count(p->length());
+            p->~string_data();
+            string_allocator_type().deallocate(reinterpret_cast<string_storage_type*>(p), count);
         }
 
-        static const size_t small_string_capacity = (sizeof(int64_t)/sizeof(Char)) - 1;
+        // Strings up to small_string_capacity characters are kept inline
+        // with their terminator instead of in a separate string_data block
+        static const size_t small_string_buffer_length = (2*sizeof(int64_t))/sizeof(Char);
+        static const size_t small_string_capacity = small_string_buffer_length - 1;
 
         variant()
             : type_(value_types::empty_object_t)
@@ -536,13 +574,13 @@ public:
                         value_ = val.value_;
                         break;
                     default:
-                        swap(variant(val));
+                        variant(val).swap(*this);
                         break;
                     }
                     break;
                 default:
                     {
-                        swap(variant(val));
+                        variant(val).swap(*this);
                     }
                     break;
                 }
@@ -616,8 +654,8 @@ public:
             case value_types::double_t:
                 if (s.length() > variant::small_string_capacity)
                 {
-                    type_ = value_types::string_t;
                     value_.string_value_ = make_string_data(s.c_str(),s.length());
+                    type_ = value_types::string_t;
                 }
                 else
                 {
@@ -647,8 +685,8 @@ public:
 				{
 					if (length > variant::small_string_capacity)
 					{
-						type_ = value_types::string_t;
 						value_.string_value_ = make_string_data(s,length);
+						type_ = value_types::string_t;
 					}
 					else
 					{
@@ -927,7 +965,7 @@ public:
             json_array<basic_json<Char,Alloc>,Alloc>* array_;
             any* any_value_;
             string_data* string_value_;
-            Char small_string_value_[sizeof(int64_t)/sizeof(Char)];
+            Char small_string_value_[small_string_buffer_length];
         } value_;
     };
 
@@ -950,7 +988,7 @@ public:
     template <typename structure, bool is_const_iterator = true>
     class range 
     {
-        typedef typename std::conditional<is_const_iterator, typename const structure&, typename structure&>::type structure_ref;
+        typedef typename std::conditional<is_const_iterator, const structure&, structure&>::type structure_ref;
         typedef typename std::conditional<is_const_iterator, typename structure::const_iterator, typename structure::iterator>::type iterator;
         typedef typename structure::const_iterator const_iterator;
         structure_ref val_;
@@ -1560,11 +1598,11 @@ public:
     // Deprecated
     static basic_json parse(std::basic_istream<Char>& is)
     {
-        parse_stream(is);
+        return parse_stream(is);
     }
     static basic_json parse(std::basic_istream<Char>& is, basic_parse_error_handler<Char>& err_handler)
     {
-        parse_stream(is,err_handler);
+        return parse_stream(is,err_handler);
     }
 
     static basic_json parse(const std::basic_string<Char>& s);
@@ -1934,6 +1972,19 @@ public:
         }
     }
 
+    // Adds object members in bulk with a single sort, see json_object::insert
+    template <class InputIt>
+    void insert_members(InputIt first, InputIt last)
+    {
+        object_value().insert(first, last);
+    }
+
+    template <class InputIt>
+    void insert_members(sorted_unique_range_tag tag, InputIt first, InputIt last)
+    {
+        object_value().insert(tag, first, last);
+    }
+
     void resize(size_t n)
     {
         switch (var_.type_)
@@ -2595,11 +2646,11 @@ public:
     }
     void assign_longlong(long long rhs)
     {
-        var_.assign(rhs);
+        var_.assign(static_cast<int64_t>(rhs));
     }
     void assign_ulonglong(unsigned long long rhs)
     {
-        var_.assign(rhs);
+        var_.assign(static_cast<uint64_t>(rhs));
     }
 
     static basic_json make_2d_array(size_t m, size_t n);
@@ -2743,7 +2794,7 @@ public:
         switch (var_.type_)
         {
         case value_types::empty_object_t:
-            return cobject().object_value();
+            return empty_object();
         case value_types::object_t:
             return *(var_.value_.object_);
         default:
@@ -2753,10 +2804,11 @@ public:
     }
 
 private:
-    const basic_json<Char,Alloc>& cobject() const
+    // Not allocated through Alloc, so that it outlives any arena
+    static const object& empty_object()
     {
-        static const basic_json<Char, Alloc> c = basic_json<Char, Alloc>(value_types::object_t,0);
-        return c;
+        static const object empty;
+        return empty;
     }
 
     template<typename Char2, typename Allocator2, size_t size>
@@ -2817,7 +2869,7 @@ private:
 
     friend std::basic_istream<Char>& operator<<(std::basic_istream<Char>& is, basic_json<Char, Alloc>& o)
     {
-        basic_json_deserializer<Char, Alloc> handler;
+        basic_json_deserializer<basic_json<Char, Alloc>> handler;
         basic_json_reader<Char> reader(is, handler);
         reader.read_next();
         reader.check_done();
@@ -3317,7 +3369,7 @@ typename basic_json<Char, Alloc>::const_object_iterator basic_json<Char, Alloc>:
     switch (var_.type_)
     {
     case value_types::empty_object_t:
-        return cobject().begin_members();
+        return empty_object().begin();
     case value_types::object_t:
         return var_.value_.object_->begin();
     default:
@@ -3346,7 +3398,7 @@ typename basic_json<Char, Alloc>::const_object_iterator basic_json<Char, Alloc>:
     switch (var_.type_)
     {
     case value_types::empty_object_t:
-        return cobject().end_members();
+        return empty_object().end();
     case value_types::object_t:
         return var_.value_.object_->end();
     default:
@@ -0,0 +1,188 @@
+// Copyright 2013 Daniel Parker
+// Distributed under the Boost license, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// See https://sourceforge.net/projects/jsoncons/files/ for latest version
+// See https://sourceforge.net/p/jsoncons/wiki/Home/ for documentation.
+
+#ifndef JSONCONS_JSON_CHAR_SCAN_HPP
+#define JSONCONS_JSON_CHAR_SCAN_HPP
+
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#define JSONCONS_SCAN_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSONCONS_SCAN_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace jsoncons {
+
+// Index of the lowest set bit of a non-zero mask
+inline unsigned int first_set_bit(uint32_t mask)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+}
+
+// Finds the end of a run of characters that stand for themselves inside a
+// JSON string, that is the first quote, backslash or control character at
+// or after p, or end. Narrow strings are scanned 16 or 32 bytes at a time
+// where SSE2 or AVX2 is enabled at compile time; bytes of multi-byte UTF-8
+// sequences are ordinary characters.
+
+template <typename Char>
+const Char* skip_plain_string_chars(const Char* p, const Char* end)
+{
+    typedef typename std::make_unsigned<Char>::type uchar_type;
+    while (p < end && *p != '\"' && *p != '\\' && static_cast<uchar_type>(*p) >= 0x20)
+    {
+        ++p;
+    }
+    return p;
+}
+
+inline const char* skip_plain_string_chars(const char* p, const char* end)
+{
+#if defined(JSONCONS_SCAN_AVX2)
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i max_control = _mm256_set1_epi8(0x1f);
+    while (end - p >= 32)
+    {
+        __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chars, quote), _mm256_cmpeq_epi8(chars, backslash)),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(chars, max_control), chars));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(special));
+        if (mask != 0)
+        {
+            return p + first_set_bit(mask);
+        }
+        p += 32;
+    }
+#elif defined(JSONCONS_SCAN_SSE2)
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i max_control = _mm_set1_epi8(0x1f);
+    while (end - p >= 16)
+    {
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        // chars <= 0x1f unsigned where min(chars, 0x1f) == chars
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chars, quote), _mm_cmpeq_epi8(chars, backslash)),
+            _mm_cmpeq_epi8(_mm_min_epu8(chars, max_control), chars));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(special));
+        if (mask != 0)
+        {
+            return p + first_set_bit(mask);
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '\"' && *p != '\\' && static_cast<unsigned char>(*p) >= 0x20)
+    {
+        ++p;
+    }
+    return p;
+}
+
+// Finds the end of a run of characters a serializer copies unchanged into
+// a JSON string: the first quote, backslash or control character (DEL
+// included) at or after p, or end, and also the first solidus or non-ASCII
+// character when those are to be escaped. Multi-byte UTF-8 sequences are
+// copied as they are otherwise.
+
+template <typename Char>
+const Char* skip_plain_output_chars(const Char* p, const Char* end, bool escape_solidus, bool escape_non_ascii)
+{
+    typedef typename std::make_unsigned<Char>::type uchar_type;
+    while (p < end)
+    {
+        uchar_type c = static_cast<uchar_type>(*p);
+        if (c == '\"' || c == '\\' || c < 0x20 || c == 0x7f || (escape_solidus && c == '/') || (escape_non_ascii && c >= 0x80))
+        {
+            break;
+        }
+        ++p;
+    }
+    return p;
+}
+
+inline const char* skip_plain_output_chars(const char* p, const char* end, bool escape_solidus, bool escape_non_ascii)
+{
+#if defined(JSONCONS_SCAN_AVX2)
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i max_control = _mm256_set1_epi8(0x1f);
+    const __m256i del = _mm256_set1_epi8(0x7f);
+    // A byte no input matches when solidus is not escaped
+    const __m256i solidus = escape_solidus ? _mm256_set1_epi8('/') : quote;
+    const uint32_t non_ascii = escape_non_ascii ? 0xffffffff : 0;
+    while (end - p >= 32)
+    {
+        __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chars, quote), _mm256_cmpeq_epi8(chars, backslash)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(chars, max_control), chars),
+                _mm256_or_si256(_mm256_cmpeq_epi8(chars, del), _mm256_cmpeq_epi8(chars, solidus))));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(special))
+            | (static_cast<uint32_t>(_mm256_movemask_epi8(chars)) & non_ascii);
+        if (mask != 0)
+        {
+            return p + first_set_bit(mask);
+        }
+        p += 32;
+    }
+#elif defined(JSONCONS_SCAN_SSE2)
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i max_control = _mm_set1_epi8(0x1f);
+    const __m128i del = _mm_set1_epi8(0x7f);
+    // A byte no input matches when solidus is not escaped
+    const __m128i solidus = escape_solidus ? _mm_set1_epi8('/') : quote;
+    const uint32_t non_ascii = escape_non_ascii ? 0xffff : 0;
+    while (end - p >= 16)
+    {
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chars, quote), _mm_cmpeq_epi8(chars, backslash)),
+            _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(chars, max_control), chars),
+                _mm_or_si128(_mm_cmpeq_epi8(chars, del), _mm_cmpeq_epi8(chars, solidus))));
+        // The sign bits are the non-ASCII bytes
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(special))
+            | (static_cast<uint32_t>(_mm_movemask_epi8(chars)) & non_ascii);
+        if (mask != 0)
+        {
+            return p + first_set_bit(mask);
+        }
+        p += 16;
+    }
+#endif
+    while (p < end)
+    {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '\"' || c == '\\' || c < 0x20 || c == 0x7f || (escape_solidus && c == '/') || (escape_non_ascii && c >= 0x80))
+        {
+            break;
+        }
+        ++p;
+    }
+    return p;
+}
+
+}
+
+#endif
@@ -81,7 +81,7 @@ private:
             depth_ *= 2;
             stack_.resize(depth_);
         }
-        stack_[top_].value = typename JsonT::make_array();
+        stack_[top_].value = JsonT::make_array();
     }
 
     void pop_object()
@@ -98,6 +98,9 @@ private:
 
     void do_begin_json() override
     {
+        // Starts over after a text that failed to parse, so that one
+        // deserializer can read many texts
+        top_ = -1;
         is_valid_ = false;
     }
 
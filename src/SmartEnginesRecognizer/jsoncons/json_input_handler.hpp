@@ -13,12 +13,24 @@
 
 namespace jsoncons {
 
+// Any number of up to this many decimal digits fits in int64_t, so the
+// overflow checks are only needed for longer ones
+const size_t max_safe_integer_digits = 18;
+
 template<typename CharT>
 uint64_t string_to_uinteger(const CharT *s, size_t length) throw(std::overflow_error)
 {
     static const uint64_t max_value = std::numeric_limits<uint64_t>::max JSONCONS_NO_MACRO_EXP();
     static const uint64_t max_value_div_10 = max_value / 10;
     uint64_t n = 0;
+    if (length <= max_safe_integer_digits)
+    {
+        for (size_t i = 0; i < length; ++i)
+        {
+            n = n*10 + static_cast<uint64_t>(s[i] - '0');
+        }
+        return n;
+    }
     for (size_t i = 0; i < length; ++i)
     {
         uint64_t x = s[i] - '0';
@@ -44,6 +56,14 @@ int64_t string_to_integer(bool has_neg, const CharT *s, size_t length) throw(std
     const long long max_value_div_10 = max_value / 10;
 
     long long n = 0;
+    if (length <= max_safe_integer_digits)
+    {
+        for (size_t i = 0; i < length; ++i)
+        {
+            n = n*10 + (s[i] - '0');
+        }
+        return has_neg ? -n : n;
+    }
     for (size_t i = 0; i < length; ++i)
     {
         long long x = s[i] - '0';
@@ -255,11 +275,11 @@ private:
     {
     }
 
-    void do_integer_value(long long, const basic_parsing_context<Char>&) override
+    void do_integer_value(int64_t, const basic_parsing_context<Char>&) override
     {
     }
 
-    void do_uinteger_value(unsigned long long, const basic_parsing_context<Char>&) override
+    void do_uinteger_value(uint64_t, const basic_parsing_context<Char>&) override
     {
     }
 
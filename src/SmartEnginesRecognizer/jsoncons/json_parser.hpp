@@ -20,6 +20,7 @@
 #include "jsoncons/json_input_handler.hpp"
 #include "jsoncons/parse_error_handler.hpp"
 #include "jsoncons/json_error_category.hpp"
+#include "jsoncons/json_char_scan.hpp"
 
 namespace jsoncons {
 
@@ -278,7 +279,7 @@ public:
                 ++p_;
                 break;
             default:
-                ++p_;
+                p_ = skip_plain_string_chars(p_ + 1, end_input_);
                 break;
             }
             //++p_;
@@ -0,0 +1,364 @@
+// Copyright 2013 Daniel Parker
+// Distributed under the Boost license, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// See https://sourceforge.net/projects/jsoncons/files/ for latest version
+// See https://sourceforge.net/p/jsoncons/wiki/Home/ for documentation.
+
+#ifndef JSONCONS_JSON_PATH_EXTRACTOR_HPP
+#define JSONCONS_JSON_PATH_EXTRACTOR_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "jsoncons/json1.hpp"
+
+namespace jsoncons {
+
+// Input handler that keeps only the values at a set of paths given up
+// front, such as "data.series.value", "matches.0.score" or
+// "matches.length", and skips everything else. Paths are compiled into a
+// tree of member names and array indexes; a number selects an array element
+// and a final "length" the number of elements of an array. Once every path
+// has been seen, reading a text allocates nothing but the space a longer
+// string value needs.
+template <typename Char>
+class basic_json_path_extractor : public basic_json_input_handler<Char>
+{
+public:
+    static const size_t npos = static_cast<size_t>(-1);
+
+    // Value found at a path. Objects and arrays only report their type.
+    struct slot
+    {
+        bool found;
+        value_types::value_types_t type;
+        bool bool_value;
+        int64_t integer_value;
+        uint64_t uinteger_value;
+        double double_value;
+        std::basic_string<Char> string_value;
+
+        slot()
+            : found(false), type(value_types::null_t), bool_value(false),
+              integer_value(0), uinteger_value(0), double_value(0)
+        {
+        }
+
+        bool is_number() const
+        {
+            return found && (type == value_types::integer_t || type == value_types::uinteger_t || type == value_types::double_t);
+        }
+
+        // Any number as a double, or 0
+        double as_double() const
+        {
+            switch (type)
+            {
+            case value_types::integer_t:
+                return static_cast<double>(integer_value);
+            case value_types::uinteger_t:
+                return static_cast<double>(uinteger_value);
+            case value_types::double_t:
+                return double_value;
+            default:
+                return 0;
+            }
+        }
+    };
+
+    basic_json_path_extractor()
+        : pending_(npos)
+    {
+        nodes_.push_back(node(std::basic_string<Char>(), npos));
+        stack_.reserve(default_depth);
+    }
+
+    // Adds a path of components separated by '.' and returns the index of
+    // its slot. Adding the same path twice returns the same slot.
+    size_t add_path(const std::basic_string<Char>& path)
+    {
+        size_t current = 0;
+        size_t parent = 0;
+        size_t start = 0;
+        bool last_is_length = false;
+        while (start <= path.length())
+        {
+            size_t end = path.find('.', start);
+            if (end == std::basic_string<Char>::npos)
+            {
+                end = path.length();
+            }
+            std::basic_string<Char> component = path.substr(start, end - start);
+            parent = current;
+            current = child(current, component);
+            last_is_length = component == length_name();
+            start = end + 1;
+        }
+
+        node& target = nodes_[current];
+        if (target.slot == npos)
+        {
+            target.slot = slots_.size();
+            slots_.push_back(slot());
+        }
+        if (last_is_length)
+        {
+            nodes_[parent].length_slot = target.slot;
+        }
+        return target.slot;
+    }
+
+    size_t size() const
+    {
+        return slots_.size();
+    }
+
+    const slot& operator[](size_t i) const
+    {
+        return slots_[i];
+    }
+private:
+    static const size_t default_depth = 16;
+
+    struct node
+    {
+        node(const std::basic_string<Char>& name_, size_t index_)
+            : name(name_), index(index_), slot(npos), length_slot(npos)
+        {
+        }
+
+        std::basic_string<Char> name;
+        size_t index;             // element index, npos for a member name
+        std::vector<size_t> children;
+        size_t slot;              // slot of the path ending here
+        size_t length_slot;       // slot of "<this path>.length"
+    };
+
+    struct frame
+    {
+        size_t node;              // npos while skipping the value
+        bool is_array;
+        size_t element_count;
+    };
+
+    static const std::basic_string<Char>& length_name()
+    {
+        static const std::basic_string<Char> name = {'l','e','n','g','t','h'};
+        return name;
+    }
+
+    size_t child(size_t parent, const std::basic_string<Char>& component)
+    {
+        bool is_index = !component.empty();
+        size_t index = 0;
+        for (size_t i = 0; i < component.length() && is_index; ++i)
+        {
+            is_index = component[i] >= '0' && component[i] <= '9';
+            index = index*10 + (component[i] - '0');
+        }
+        if (!is_index)
+        {
+            index = npos;
+        }
+
+        for (size_t c : nodes_[parent].children)
+        {
+            if (nodes_[c].index == index && (is_index || nodes_[c].name == component))
+            {
+                return c;
+            }
+        }
+        nodes_.push_back(node(is_index ? std::basic_string<Char>() : component, index));
+        nodes_[parent].children.push_back(nodes_.size() - 1);
+        return nodes_.size() - 1;
+    }
+
+    size_t find_member(size_t parent, const Char* name, size_t length) const
+    {
+        for (size_t c : nodes_[parent].children)
+        {
+            const node& n = nodes_[c];
+            if (n.index == npos && n.name.length() == length && std::char_traits<Char>::compare(n.name.data(), name, length) == 0)
+            {
+                return c;
+            }
+        }
+        return npos;
+    }
+
+    size_t find_element(size_t parent, size_t index) const
+    {
+        for (size_t c : nodes_[parent].children)
+        {
+            if (nodes_[c].index == index)
+            {
+                return c;
+            }
+        }
+        return npos;
+    }
+
+    // Node of the value that starts now
+    size_t next_value_node()
+    {
+        if (stack_.empty())
+        {
+            return 0;
+        }
+        frame& top = stack_.back();
+        if (top.is_array)
+        {
+            size_t n = top.node == npos ? npos : find_element(top.node, top.element_count);
+            ++top.element_count;
+            return n;
+        }
+        size_t n = pending_;
+        pending_ = npos;
+        return n;
+    }
+
+    slot* slot_of(size_t n)
+    {
+        if (n == npos || nodes_[n].slot == npos)
+        {
+            return nullptr;
+        }
+        slot* s = &slots_[nodes_[n].slot];
+        s->found = true;
+        return s;
+    }
+
+    void begin_structure(value_types::value_types_t type)
+    {
+        size_t n = next_value_node();
+        slot* s = slot_of(n);
+        if (s != nullptr)
+        {
+            s->type = type;
+        }
+
+        bool descend = n != npos && (!nodes_[n].children.empty() || nodes_[n].length_slot != npos);
+        frame f = {descend ? n : npos, type == value_types::array_t, 0};
+        stack_.push_back(f);
+    }
+
+    void do_begin_json() override
+    {
+        for (slot& s : slots_)
+        {
+            s.found = false;
+        }
+        stack_.clear();
+        pending_ = npos;
+    }
+
+    void do_end_json() override
+    {
+    }
+
+    void do_begin_object(const basic_parsing_context<Char>&) override
+    {
+        begin_structure(value_types::object_t);
+    }
+
+    void do_end_object(const basic_parsing_context<Char>&) override
+    {
+        stack_.pop_back();
+    }
+
+    void do_begin_array(const basic_parsing_context<Char>&) override
+    {
+        begin_structure(value_types::array_t);
+    }
+
+    void do_end_array(const basic_parsing_context<Char>&) override
+    {
+        const frame& top = stack_.back();
+        if (top.node != npos && nodes_[top.node].length_slot != npos)
+        {
+            slot& s = slots_[nodes_[top.node].length_slot];
+            s.found = true;
+            s.type = value_types::uinteger_t;
+            s.uinteger_value = top.element_count;
+        }
+        stack_.pop_back();
+    }
+
+    void do_name(const Char* name, size_t length, const basic_parsing_context<Char>&) override
+    {
+        size_t parent = stack_.empty() ? npos : stack_.back().node;
+        pending_ = parent == npos ? npos : find_member(parent, name, length);
+    }
+
+    void do_null_value(const basic_parsing_context<Char>&) override
+    {
+        slot* s = slot_of(next_value_node());
+        if (s != nullptr)
+        {
+            s->type = value_types::null_t;
+        }
+    }
+
+    void do_string_value(const Char* value, size_t length, const basic_parsing_context<Char>&) override
+    {
+        slot* s = slot_of(next_value_node());
+        if (s != nullptr)
+        {
+            s->type = value_types::string_t;
+            s->string_value.assign(value, length);
+        }
+    }
+
+    void do_double_value(double value, const basic_parsing_context<Char>&) override
+    {
+        slot* s = slot_of(next_value_node());
+        if (s != nullptr)
+        {
+            s->type = value_types::double_t;
+            s->double_value = value;
+        }
+    }
+
+    void do_integer_value(int64_t value, const basic_parsing_context<Char>&) override
+    {
+        slot* s = slot_of(next_value_node());
+        if (s != nullptr)
+        {
+            s->type = value_types::integer_t;
+            s->integer_value = value;
+        }
+    }
+
+    void do_uinteger_value(uint64_t value, const basic_parsing_context<Char>&) override
+    {
+        slot* s = slot_of(next_value_node());
+        if (s != nullptr)
+        {
+            s->type = value_types::uinteger_t;
+            s->uinteger_value = value;
+        }
+    }
+
+    void do_bool_value(bool value, const basic_parsing_context<Char>&) override
+    {
+        slot* s = slot_of(next_value_node());
+        if (s != nullptr)
+        {
+            s->type = value_types::bool_t;
+            s->bool_value = value;
+        }
+    }
+
+    std::vector<node> nodes_;
+    std::vector<slot> slots_;
+    std::vector<frame> stack_;
+    size_t pending_;
+};
+
+typedef basic_json_path_extractor<char> json_path_extractor;
+typedef basic_json_path_extractor<wchar_t> wjson_path_extractor;
+
+}
+
+#endif
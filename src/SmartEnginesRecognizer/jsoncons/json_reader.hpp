@@ -33,6 +33,7 @@ class basic_json_reader
     basic_parse_error_handler<Char> *err_handler_;
     bool eof_;
     std::vector<Char> buffer_;
+    const Char* data_;
     size_t buffer_length_;
     size_t buffer_capacity_;
     size_t index_;
@@ -48,6 +49,7 @@ public:
           index_(0)
     {
         buffer_.resize(buffer_capacity_);
+        data_ = buffer_.data();
     }
 
     basic_json_reader(std::basic_istream<Char>& is,
@@ -62,6 +64,36 @@ public:
          index_(0)
     {
         buffer_.resize(buffer_capacity_);
+        data_ = buffer_.data();
+    }
+
+    // Reads the text in [data, data + length), such as a memory-mapped file,
+    // in place. The text must outlive the reader.
+    basic_json_reader(const Char* data, size_t length,
+                      basic_json_input_handler<Char>& handler)
+        : parser_(handler),
+          is_(nullptr),
+          err_handler_(std::addressof(basic_default_parse_error_handler<Char>::instance())),
+          eof_(false),
+          data_(data),
+          buffer_length_(length),
+          buffer_capacity_(0),
+          index_(0)
+    {
+    }
+
+    basic_json_reader(const Char* data, size_t length,
+                      basic_json_input_handler<Char>& handler,
+                      basic_parse_error_handler<Char>& err_handler)
+        : parser_(handler,err_handler),
+          is_(nullptr),
+          err_handler_(std::addressof(err_handler)),
+          eof_(false),
+          data_(data),
+          buffer_length_(length),
+          buffer_capacity_(0),
+          index_(0)
+    {
     }
 
     size_t buffer_capacity() const
@@ -69,10 +101,15 @@ public:
         return buffer_capacity_;
     }
 
+    // Has no effect when reading from a contiguous buffer
     void buffer_capacity(size_t capacity)
     {
-        buffer_capacity_ = capacity;
-        buffer_.resize(buffer_capacity_);
+        if (is_ != nullptr)
+        {
+            buffer_capacity_ = capacity;
+            buffer_.resize(buffer_capacity_);
+            data_ = buffer_.data();
+        }
     }
 
     size_t max_nesting_depth() const
@@ -92,24 +129,11 @@ public:
         {
             if (!(index_ < buffer_length_))
             {
-                if (!is_->eof())
-                {
-                    is_->read(buffer_.data(), buffer_capacity_);
-                    buffer_length_ = static_cast<size_t>(is_->gcount());
-                    if (buffer_length_ == 0)
-                    {
-                        eof_ = true;
-                    }
-                    index_ = 0;
-                }
-                else
-                {
-                    eof_ = true;
-                }
+                read_buffer();
             }
             if (!eof_)
             {
-                parser_.parse(buffer_.data(),index_,buffer_length_);
+                parser_.parse(data_,index_,buffer_length_);
                 index_ = parser_.index();
             }
         }
@@ -122,24 +146,11 @@ public:
         {
             if (!(index_ < buffer_length_))
             {
-                if (!is_->eof())
-                {
-                    is_->read(buffer_.data(), buffer_capacity_);
-                    buffer_length_ = static_cast<size_t>(is_->gcount());
-                    if (buffer_length_ == 0)
-                    {
-                        eof_ = true;
-                    }
-                    index_ = 0;
-                }
-                else
-                {
-                    eof_ = true;
-                }
+                read_buffer();
             }
             if (!eof_)
             {
-                parser_.check_done(buffer_.data(),index_,buffer_length_);
+                parser_.check_done(data_,index_,buffer_length_);
                 index_ = parser_.index();
             }
         }
@@ -165,6 +176,26 @@ public:
     {
         parser_.max_nesting_depth(depth);
     }
+private:
+    // A contiguous buffer is read in one piece, so running out of it is the
+    // end of input
+    void read_buffer()
+    {
+        if (is_ != nullptr && !is_->eof())
+        {
+            is_->read(buffer_.data(), buffer_capacity_);
+            buffer_length_ = static_cast<size_t>(is_->gcount());
+            if (buffer_length_ == 0)
+            {
+                eof_ = true;
+            }
+            index_ = 0;
+        }
+        else
+        {
+            eof_ = true;
+        }
+    }
 };
 
 typedef basic_json_reader<char> json_reader;
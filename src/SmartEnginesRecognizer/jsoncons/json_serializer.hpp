@@ -84,10 +84,37 @@ public:
     {
     }
 
+    // Serializes into sink through a buffer of buffer_length characters,
+    // aligned to alignment bytes
+    basic_json_serializer(basic_output_sink<Char>& sink, size_t buffer_length = default_buffer_length, size_t alignment = 0)
+       : indent_(0),
+         indenting_(false),
+         fp_(format_.precision()),
+         bos_(sink, buffer_length, alignment)
+    {
+    }
+
+    basic_json_serializer(basic_output_sink<Char>& sink, const basic_output_format<Char>& format, bool indenting,
+                          size_t buffer_length = default_buffer_length, size_t alignment = 0)
+       : format_(format),
+         indent_(0),
+         indenting_(indenting),
+         fp_(format_.precision()),
+         bos_(sink, buffer_length, alignment)
+    {
+    }
+
     ~basic_json_serializer()
     {
     }
 
+    // Writes what has been serialized so far through to the stream, which
+    // may be in the middle of a value
+    void flush()
+    {
+        bos_.flush();
+    }
+
 private:
     // Implementing methods
     void do_begin_json() override
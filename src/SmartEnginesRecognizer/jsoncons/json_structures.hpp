@@ -18,6 +18,7 @@
 #include <sstream>
 #include <iomanip>
 #include <utility>
+#include <iterator>
 #include <new>
 #include "jsoncons/jsoncons.hpp"
 
@@ -61,6 +62,11 @@ public:
     }
 };
 
+// Marks a range of members that is already sorted by name, without duplicates
+struct sorted_unique_range_tag
+{
+};
+
 template <class JsonT, typename Alloc>
 class json_array 
 {
@@ -69,8 +75,9 @@ public:
     typedef Alloc allocator_type;
     typedef JsonT& reference; 
     typedef const JsonT& const_reference; 
-    typedef typename std::vector<JsonT>::iterator iterator;
-    typedef typename std::vector<JsonT>::const_iterator const_iterator;
+    typedef std::vector<JsonT,typename Alloc::template rebind<JsonT>::other> elements_type;
+    typedef typename elements_type::iterator iterator;
+    typedef typename elements_type::const_iterator const_iterator;
 
     // Allocation
     static void* operator new(std::size_t) { return typename Alloc::template rebind<json_array>::other().allocate(1); }
@@ -200,7 +207,7 @@ public:
         return true;
     }
 private:
-    std::vector<JsonT> elements_;
+    elements_type elements_;
     json_array& operator=(const json_array<JsonT,Alloc>&);
 };
 
@@ -268,8 +275,8 @@ public:
     {
         if (this != & member)
         {
-            name_ = member.name;
-            value_ = member.value;
+            name_ = member.name_;
+            value_ = member.value_;
         }
         return *this;
     }
@@ -298,8 +305,9 @@ public:
     typedef Alloc allocator_type;
     typedef value_type& reference; 
     typedef const value_type& const_reference; 
-    typedef typename std::vector<value_type>::iterator iterator;
-    typedef typename std::vector<value_type>::const_iterator const_iterator;
+    typedef std::vector<value_type,typename Alloc::template rebind<value_type>::other> members_type;
+    typedef typename members_type::iterator iterator;
+    typedef typename members_type::const_iterator const_iterator;
 
     // Allocation
     static void* operator new(std::size_t) { return typename Alloc::template rebind<json_object>::other().allocate(1); }
@@ -360,7 +368,7 @@ public:
     }
 
     json_object(std::vector<value_type> members)
-        : members_(members)
+        : members_(std::make_move_iterator(members.begin()),std::make_move_iterator(members.end()))
     {
     }
 
@@ -611,11 +619,55 @@ public:
         return it;
     }
 
+    // Bulk construction: push_back appends without keeping the members
+    // sorted, and sort_unique_members restores the order once at the end.
+    // Building an object this way is O(n log n) instead of the O(n^2) moves
+    // of one set per member.
+
     void push_back(std::basic_string<char_type>&& name, JsonT&& val)
     {
         members_.push_back(value_type(std::move(name), std::move(val)));
     }
 
+    void push_back(const std::basic_string<char_type>& name, const JsonT& val)
+    {
+        members_.push_back(value_type(name, val));
+    }
+
+    void push_back(const std::basic_string<char_type>& name, JsonT&& val)
+    {
+        members_.push_back(value_type(name, std::move(val)));
+    }
+
+    // Sorts the members by name; of members with the same name only the one
+    // added last is kept, as if each had been added with set
+    void sort_unique_members()
+    {
+        std::stable_sort(members_.begin(),members_.end(),member_compare<value_type>());
+        unique_members(members_.begin());
+    }
+
+    // Adds the members [first, last), replacing existing members with the
+    // same name, with a single sort
+    template <class InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        size_t old_size = members_.size();
+        members_.insert(members_.end(), first, last);
+        std::stable_sort(members_.begin() + old_size,members_.end(),member_compare<value_type>());
+        merge_members(old_size);
+    }
+
+    // Same for members that are known to be sorted by name and unique, which
+    // takes linear time
+    template <class InputIt>
+    void insert(sorted_unique_range_tag, InputIt first, InputIt last)
+    {
+        size_t old_size = members_.size();
+        members_.insert(members_.end(), first, last);
+        merge_members(old_size);
+    }
+
     JsonT& at(const std::basic_string<char_type>& name) 
     {
         auto it = find(name);
@@ -692,7 +744,52 @@ public:
 
 private:
 
-    std::vector<value_type> members_;
+    // Merges the sorted members from old_size on into the sorted members
+    // before it; a later member replaces an earlier one with the same name
+    void merge_members(size_t old_size)
+    {
+        if (old_size == members_.size())
+        {
+            return;
+        }
+        if (old_size == 0)
+        {
+            unique_members(members_.begin());
+            return;
+        }
+        auto middle = members_.begin() + old_size;
+        if (!((middle - 1)->name() < middle->name()))
+        {
+            std::inplace_merge(members_.begin(),middle,members_.end(),member_compare<value_type>());
+            unique_members(members_.begin());
+        }
+        else
+        {
+            unique_members(middle - 1);
+        }
+    }
+
+    // Removes all but the last of every run of equal names from first on
+    void unique_members(iterator first)
+    {
+        iterator out = first;
+        for (iterator it = first; it != members_.end(); ++it)
+        {
+            iterator next = it + 1;
+            if (next != members_.end() && next->name() == it->name())
+            {
+                continue;
+            }
+            if (out != it)
+            {
+                *out = std::move(*it);
+            }
+            ++out;
+        }
+        members_.erase(out,members_.end());
+    }
+
+    members_type members_;
     json_object<JsonT,Alloc>& operator=(const json_object<JsonT,Alloc>&);
 };
 
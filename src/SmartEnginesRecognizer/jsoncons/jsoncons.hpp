@@ -21,32 +21,157 @@
 
 namespace jsoncons {
 
+// Destination of the characters a buffered_ostream collects
+template <typename Char>
+class basic_output_sink
+{
+public:
+    virtual ~basic_output_sink()
+    {
+    }
+
+    virtual void write(const Char* s, size_t length) = 0;
+
+    // Writes s1 followed by s2, in one operation where the sink can
+    virtual void write(const Char* s1, size_t length1, const Char* s2, size_t length2)
+    {
+        write(s1, length1);
+        write(s2, length2);
+    }
+
+    // Called by buffered_ostream::flush after the buffer has been written
+    virtual void flush()
+    {
+    }
+};
+
+// Sink over a std::basic_ostream. Flushing the stream on every
+// buffered_ostream::flush can be turned off.
+template <typename Char>
+class basic_ostream_sink : public basic_output_sink<Char>
+{
+    std::basic_ostream<Char>* os_;
+    bool flush_stream_;
+public:
+    basic_ostream_sink(std::basic_ostream<Char>& os, bool flush_stream = true)
+        : os_(std::addressof(os)), flush_stream_(flush_stream)
+    {
+    }
+
+    void write(const Char* s, size_t length) override
+    {
+        os_->write(s, length);
+    }
+
+    void flush() override
+    {
+        if (flush_stream_)
+        {
+            os_->flush();
+        }
+    }
+};
+
+// Sink that appends to a string
+template <typename Char>
+class basic_string_sink : public basic_output_sink<Char>
+{
+    std::basic_string<Char>* s_;
+public:
+    explicit basic_string_sink(std::basic_string<Char>& s)
+        : s_(std::addressof(s))
+    {
+    }
+
+    void write(const Char* s, size_t length) override
+    {
+        s_->append(s, length);
+    }
+};
+
+typedef basic_output_sink<char> output_sink;
+typedef basic_output_sink<wchar_t> woutput_sink;
+typedef basic_ostream_sink<char> ostream_sink;
+typedef basic_ostream_sink<wchar_t> wostream_sink;
+typedef basic_string_sink<char> string_sink;
+typedef basic_string_sink<wchar_t> wstring_sink;
+
 template <typename Char>
 class buffered_ostream
 {
     static const size_t default_buffer_length = 16384;
 
     std::basic_ostream<Char>* os_;
+    basic_output_sink<Char>* sink_;
     std::vector<Char> buffer_;
     Char * const begin_buffer_;
 	const Char* const end_buffer_;
     Char* p_;
+
+    // Sizes buffer for length characters starting at an address that is a
+    // multiple of alignment bytes, and returns that start
+    static Char* aligned_buffer(std::vector<Char>& buffer, size_t length, size_t alignment)
+    {
+        buffer.resize(length + (alignment + sizeof(Char) - 1)/sizeof(Char));
+        uintptr_t address = reinterpret_cast<uintptr_t>(buffer.data());
+        size_t offset = alignment > 1 ? (alignment - address % alignment) % alignment : 0;
+        return reinterpret_cast<Char*>(address + offset);
+    }
+
+    void write_buffer()
+    {
+        if (sink_ != nullptr)
+        {
+            sink_->write(begin_buffer_, (p_ - begin_buffer_));
+        }
+        else
+        {
+            os_->write(begin_buffer_, (p_ - begin_buffer_));
+        }
+        p_ = begin_buffer_;
+    }
 public:
-	buffered_ostream(std::basic_ostream<Char>& os)
-		: os_(std::addressof(os)), buffer_(default_buffer_length), begin_buffer_(buffer_.data()), end_buffer_(buffer_.data()+default_buffer_length), p_(buffer_.data())
+	buffered_ostream(std::basic_ostream<Char>& os, size_t buffer_length = default_buffer_length)
+		: os_(std::addressof(os)), sink_(nullptr),
+          begin_buffer_(aligned_buffer(buffer_, buffer_length > 0 ? buffer_length : 1, 0)),
+          end_buffer_(begin_buffer_ + (buffer_length > 0 ? buffer_length : 1)), p_(begin_buffer_)
 	{
 	}
+
+    // Writes to sink through a buffer of buffer_length characters that
+    // starts at a multiple of alignment bytes
+    buffered_ostream(basic_output_sink<Char>& sink, size_t buffer_length = default_buffer_length, size_t alignment = 0)
+        : os_(nullptr), sink_(std::addressof(sink)),
+          begin_buffer_(aligned_buffer(buffer_, buffer_length > 0 ? buffer_length : 1, alignment)),
+          end_buffer_(begin_buffer_ + (buffer_length > 0 ? buffer_length : 1)), p_(begin_buffer_)
+    {
+    }
+
+    // Sinks may throw, so errors are only reported by an explicit flush
 	~buffered_ostream()
 	{
-		os_->write(begin_buffer_, (p_ - begin_buffer_));
-		os_->flush();
+        try
+        {
+            flush();
+        }
+        catch (...)
+        {
+        }
 	}
 
+    // Writes the buffer out and flushes the stream, or calls the sink's
+    // flush, which may do nothing
     void flush()
     {
-        os_->write(begin_buffer_, (p_ - begin_buffer_));
-        p_ = begin_buffer_;
-        os_->flush();
+        write_buffer();
+        if (sink_ != nullptr)
+        {
+            sink_->flush();
+        }
+        else
+        {
+            os_->flush();
+        }
     }
 
 	void write(const Char* s, size_t length)
@@ -57,6 +182,11 @@ public:
 			std::memcpy(p_, s, length*sizeof(Char));
 			p_ += length;
 		}
+		else if (sink_ != nullptr)
+		{
+			sink_->write(begin_buffer_, (p_ - begin_buffer_), s, length);
+			p_ = begin_buffer_;
+		}
 		else
 		{
 			os_->write(begin_buffer_, (p_ - begin_buffer_));
@@ -78,8 +208,7 @@ public:
 		}
 		else
 		{
-			os_->write(begin_buffer_, (p_-begin_buffer_));
-			p_ = begin_buffer_;
+			write_buffer();
 			*p_++ = c;
 		}
 	}
@@ -100,12 +229,30 @@ public:
     virtual const char* what() const JSONCONS_NOEXCEPT = 0;
 };
 
+template <typename Base>
+struct json_exception_base
+{
+    static Base make()
+    {
+        return Base("");
+    }
+};
+
+template <>
+struct json_exception_base<std::exception>
+{
+    static std::exception make()
+    {
+        return std::exception();
+    }
+};
+
 template <typename Base>
 class json_exception_0 : public Base, public virtual json_exception
 {
 public:
     json_exception_0(std::string s) JSONCONS_NOEXCEPT
-        : Base(""), message_(s)
+        : Base(json_exception_base<Base>::make()), message_(s)
     {
     }
     ~json_exception_0() JSONCONS_NOEXCEPT
@@ -124,11 +271,11 @@ class json_exception_1 : public Base, public virtual json_exception
 {
 public:
     json_exception_1(const std::string& format, const std::string& arg1) JSONCONS_NOEXCEPT
-        : Base(""), format_(format), arg1_(arg1)
+        : Base(json_exception_base<Base>::make()), format_(format), arg1_(arg1)
     {
     }
     json_exception_1(const std::string& format, const std::wstring& arg1) JSONCONS_NOEXCEPT
-        : Base(""), format_(format)
+        : Base(json_exception_base<Base>::make()), format_(format)
     {
         std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t> converter;
         arg1_ = converter.to_bytes(arg1);
@@ -17,8 +17,11 @@
 #include <iomanip>
 #include <cstdlib>
 #include <cmath>
+#include <cstring>
 #include <cstdarg>
+#include <cstdint>
 #include <limits> // std::numeric_limits
+#include "jsoncons/grisu.hpp"
 
 #define JSONCONS_NO_MACRO_EXP
 
@@ -110,6 +113,40 @@ inline bool is_neg_inf(double x)
 
 #endif
 
+template <typename Char>
+class buffered_ostream;
+
+template <typename Char>
+void print_float(double val, int precision, buffered_ostream<Char>& os);
+
+template <typename Char>
+void print_shortest_float(double val, buffered_ostream<Char>& os);
+
+// Prints with the given number of significant digits, or with the shortest
+// digits that read back as the same double when precision is 0
+template <typename Char>
+class float_printer
+{
+    int precision_;
+public:
+    float_printer(int precision)
+        : precision_(precision)
+    {
+    }
+
+    void print(double val, buffered_ostream<Char>& os)
+    {
+        if (precision_ == 0)
+        {
+            print_shortest_float(val, os);
+        }
+        else
+        {
+            print_float(val, precision_, os);
+        }
+    }
+};
+
 template<typename Char>
 std::basic_string<Char> float_to_string(double val, int precision)
 {
@@ -117,29 +154,115 @@ std::basic_string<Char> float_to_string(double val, int precision)
     ss.imbue(std::locale::classic());
     {
         buffered_ostream<Char> os(ss);
-        print_float(val, precision, os);
+        float_printer<Char>(precision).print(val, os);
     }
 	return ss.str();
 }
 
+// Same notation as print_float: fixed for decimal exponents from -4 to 14,
+// otherwise d.ddde+XX, and always with a fraction part
 template <typename Char>
-class buffered_ostream;
-
-template <typename Char>
-class float_printer
+void print_shortest_float(double val, buffered_ostream<Char>& os)
 {
-    int precision_;
-public:
-    float_printer(int precision)
-        : precision_(precision)
+    if (is_nan(val) || std::isinf(val))
     {
+        print_float(val, 17, os);
+        return;
     }
 
-    void print(double val, buffered_ostream<Char>& os)
+    char digits[17];
+    int length = 1;
+    int exponent = 0;
+    char buf[32];
+    char* p = buf;
+
+    if (std::signbit(val))
     {
-    	print_float(val, precision_, os);
+        *p++ = '-';
+        val = -val;
+    }
+    if (val == 0)
+    {
+        digits[0] = '0';
+    }
+    else
+    {
+        grisu2(val, digits, length, exponent);
+    }
+
+    // Position of the decimal point relative to the first digit
+    int point = length + exponent;
+    if (point > 0 && point <= 15)
+    {
+        if (exponent >= 0)
+        {
+            std::memcpy(p, digits, length);
+            p += length;
+            for (int i = 0; i < exponent; ++i)
+            {
+                *p++ = '0';
+            }
+            *p++ = '.';
+            *p++ = '0';
+        }
+        else
+        {
+            std::memcpy(p, digits, point);
+            p += point;
+            *p++ = '.';
+            std::memcpy(p, digits + point, length - point);
+            p += length - point;
+        }
+    }
+    else if (point <= 0 && point > -4)
+    {
+        *p++ = '0';
+        *p++ = '.';
+        for (int i = point; i < 0; ++i)
+        {
+            *p++ = '0';
+        }
+        std::memcpy(p, digits, length);
+        p += length;
+    }
+    else
+    {
+        *p++ = digits[0];
+        *p++ = '.';
+        if (length > 1)
+        {
+            std::memcpy(p, digits + 1, length - 1);
+            p += length - 1;
+        }
+        else
+        {
+            *p++ = '0';
+        }
+        *p++ = 'e';
+        int e = point - 1;
+        if (e < 0)
+        {
+            *p++ = '-';
+            e = -e;
+        }
+        else
+        {
+            *p++ = '+';
+        }
+        if (e >= 100)
+        {
+            *p++ = static_cast<char>('0' + e/100);
+            e %= 100;
+        }
+        *p++ = static_cast<char>('0' + e/10);
+        *p++ = static_cast<char>('0' + e%10);
     }
-};
+
+    for (const char* q = buf; q < p; ++q)
+    {
+        os.put(static_cast<Char>(*q));
+    }
+}
 
 #ifdef _MSC_VER
 
@@ -275,6 +398,92 @@ void print_float(double val, int precision, buffered_ostream<Char>& os)
 }
 #endif
 
+// Fast path for JSON number text (digits, optional fraction and exponent, no
+// sign): exact when the significant digits fit in 53 bits and the decimal
+// exponent is at most 22, since both operands of the one multiplication or
+// division are then exact doubles (Clinger). Returns false otherwise, and the
+// caller falls back to strtod.
+inline bool fast_string_to_double(const char* s, size_t length, double& value)
+{
+    static const double powers_of_ten[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const uint64_t max_exact_mantissa = uint64_t(1) << 53;
+
+    const char* p = s;
+    const char* end = s + length;
+    uint64_t mantissa = 0;
+    int significant_digits = 0;
+    int exponent = 0;
+
+    for (; p < end && *p >= '0' && *p <= '9'; ++p)
+    {
+        mantissa = mantissa*10 + (*p - '0');
+        significant_digits += mantissa != 0;
+        if (significant_digits > 17)
+        {
+            return false;
+        }
+    }
+    if (p < end && *p == '.')
+    {
+        for (++p; p < end && *p >= '0' && *p <= '9'; ++p)
+        {
+            mantissa = mantissa*10 + (*p - '0');
+            significant_digits += mantissa != 0;
+            if (significant_digits > 17)
+            {
+                return false;
+            }
+            --exponent;
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        ++p;
+        bool negative_exponent = false;
+        if (p < end && (*p == '+' || *p == '-'))
+        {
+            negative_exponent = *p == '-';
+            ++p;
+        }
+        if (p == end)
+        {
+            return false;
+        }
+        int e = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; ++p)
+        {
+            if (e > 1000)
+            {
+                return false;
+            }
+            e = e*10 + (*p - '0');
+        }
+        exponent += negative_exponent ? -e : e;
+    }
+    if (p != end || p == s)
+    {
+        return false;
+    }
+
+    if (mantissa == 0)
+    {
+        value = 0.0;
+        return true;
+    }
+    if (mantissa > max_exact_mantissa || exponent < -22 || exponent > 22)
+    {
+        return false;
+    }
+    value = exponent < 0
+        ? static_cast<double>(mantissa)/powers_of_ten[-exponent]
+        : static_cast<double>(mantissa)*powers_of_ten[exponent];
+    return true;
+}
+
 // string_to_float only requires narrow char
 #ifdef _MSC_VER
 class float_reader
@@ -289,9 +498,15 @@ public:
 
 	double read(const char* s, size_t length)
 	{
+        double val;
+        if (fast_string_to_double(s, length, val))
+        {
+            return val;
+        }
+
         const char *begin = s;
         char *end = nullptr;
-        double val = _strtod_l(begin, &end, locale);
+        val = _strtod_l(begin, &end, locale);
         if (begin == end)
         {
             throw std::invalid_argument("Invalid float value");
@@ -327,6 +542,11 @@ public:
 	double read(const char* s, size_t length)
 	{
         double val;
+        if (fast_string_to_double(s, length, val))
+        {
+            return val;
+        }
+
         if (is_dot_)
         {
             const char *begin = s;
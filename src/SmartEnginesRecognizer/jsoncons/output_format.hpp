@@ -16,6 +16,7 @@
 #include <cstdlib>
 #include <limits>
 #include <cwchar>
+#include "jsoncons/json_char_scan.hpp"
 
 namespace jsoncons {
 
@@ -43,7 +44,7 @@ public:
     basic_output_format()
         :
         indent_(default_indent),
-        precision_(15),
+        precision_(0),
         replace_nan_(true),
         replace_pos_inf_(true),
         replace_neg_inf_(true),
@@ -100,6 +101,8 @@ public:
 
 //  Modifiers
 
+    // Significant digits of floating point values; 0, the default, prints
+    // the shortest digits that read back as the same value
     void precision(int prec)
     {
         precision_ = prec;
@@ -167,6 +170,16 @@ void escape_string(const Char* s,
     const Char* end = s + length;
     for (const Char* it = begin; it != end; ++it)
     {
+        const Char* run_end = skip_plain_output_chars(it, end, format.escape_solidus(), format.escape_all_non_ascii());
+        if (run_end != it)
+        {
+            os.write(it, run_end - it);
+            it = run_end;
+            if (it == end)
+            {
+                break;
+            }
+        }
         Char c = *it;
         switch (c)
         {
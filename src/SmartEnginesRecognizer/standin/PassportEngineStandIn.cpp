@@ -0,0 +1,430 @@
+// Stand-in for passportEngine.lib with the same header API, for building and
+// benchmarking the driver where the vendor binary is not available.
+//
+// Configure reads a JSON file with the simulation settings (all optional):
+//   "recorded_results"  - directory laid out like result/smartengines; an
+//                         image "pack/name" replays "pack/name.json" from it,
+//                         and an image without a recording fails like it did
+//                         in the recorded run. Without it every image gets a
+//                         synthetic result derived from its path.
+//   "latency_ms"        - time every image takes, spent sleeping
+//   "latency_jitter_ms" - extra latency in [0, jitter), fixed per image
+//   "cpu_ms"            - CPU time every image burns on the calling thread
+//   "configure_ms"      - time Configure takes, spent sleeping
+//   "model_mb"          - memory every configured engine allocates and touches
+
+#include "smartengines/passport_engine.h"
+
+#include "jsoncons/json.hpp"
+using jsoncons::json;
+
+#include "Sharding.h"
+#include "Stopwatch.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+// The engine header gives PassportEngine no out-of-line destructor, so the
+// objects behind its auto_ptr members are deleted where they are incomplete.
+// Both are kept trivially destructible for that; the settings and the model
+// memory of an engine live until the process exits.
+namespace psp
+{
+	class PassportRecognizer
+	{
+	public:
+		const char *recorded_results = nullptr;
+		double latency_ms = 0;
+		double latency_jitter_ms = 0;
+		double cpu_ms = 0;
+		unsigned char *model = nullptr;
+	};
+}
+
+struct ProxyResultReporter
+{
+	PassportResultReporterInterface *reporter = nullptr;
+};
+
+namespace
+{
+	const char *CopyString(const std::string &value)
+	{
+		char *copy = new char[value.size() + 1];
+		memcpy(copy, value.c_str(), value.size() + 1);
+		return copy;
+	}
+
+	void SleepMilliseconds(double milliseconds)
+	{
+		if (milliseconds > 0)
+		{
+			std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(milliseconds));
+		}
+	}
+
+	void BurnCpu(double milliseconds)
+	{
+		double start = ThreadCpuMilliseconds();
+		volatile unsigned sink = 0;
+		while (ThreadCpuMilliseconds() - start < milliseconds)
+		{
+			for (unsigned i = 0; i < 10000; ++i)
+			{
+				sink = sink * 1664525u + 1013904223u;
+			}
+		}
+	}
+
+	// "pack/name" of an image path, or the whole path if it has no directory
+	std::string RelativeImagePath(const std::string &image_file)
+	{
+		size_t name_start = image_file.find_last_of("/\\");
+		if (name_start == std::string::npos)
+		{
+			return image_file;
+		}
+
+		size_t pack_end = image_file.find_last_not_of("/\\", name_start);
+		size_t pack_start = pack_end == std::string::npos ? std::string::npos : image_file.find_last_of("/\\", pack_end);
+		pack_start = pack_start == std::string::npos ? 0 : pack_start + 1;
+
+		std::string pack = pack_end == std::string::npos ? std::string() : image_file.substr(pack_start, pack_end - pack_start + 1);
+		return pack + "/" + image_file.substr(name_start + 1);
+	}
+
+	void SetField(PassportStringField &field, const json &value)
+	{
+		field.value = value.get("value", "").as_string();
+		field.is_accepted = value.get("confidence", "0").as_string() == "1";
+	}
+
+	void SetField(PassportDateField &field, const json &value)
+	{
+		sscanf(value.get("value", "").as_string().c_str(), "%d.%d.%d", &field.day, &field.month, &field.year);
+		field.is_accepted = value.get("confidence", "0").as_string() == "1";
+	}
+
+	void SetField(PassportGenderField &field, const json &value)
+	{
+		std::string gender = value.get("value", "").as_string();
+		field.value = gender == "M" ? PassportGenderField::Male : gender == "F" ? PassportGenderField::Female : PassportGenderField::Unknown;
+		field.is_accepted = value.get("confidence", "0").as_string() == "1";
+	}
+
+	void SetField(PassportCodeField &field, const json &value)
+	{
+		sscanf(value.get("value", "").as_string().c_str(), "%d-%d", &field.code0, &field.code1);
+		field.is_accepted = value.get("confidence", "0").as_string() == "1";
+	}
+
+	// Feeds a result file written by the driver back through the callbacks
+	void ReplayResult(const json &recorded, PassportResultReporterInterface &reporter)
+	{
+		if (recorded.get("snapshot_rejected", false).as_bool())
+		{
+			reporter.SnapshotRejected();
+		}
+
+		if (recorded.has_member("matches"))
+		{
+			for (auto match : recorded["matches"].elements())
+			{
+				PassportMatchResult match_result;
+				match_result.score = match.get("score", 0.0).as_double();
+				match_result.type = match.get("type", "").as_string();
+
+				PassportImageRequest request;
+				reporter.DocumentMatched(match_result, request);
+			}
+		}
+
+		if (!recorded.has_member("data") || recorded["data"].size() == 0)
+		{
+			return;
+		}
+
+		const json &data = recorded["data"];
+		PassportRecognitionResult result;
+		SetField(result.series,         data.get("series"));
+		SetField(result.number,         data.get("number"));
+		SetField(result.surname,        data.get("surname"));
+		SetField(result.name,           data.get("name"));
+		SetField(result.patronymic,     data.get("patronymic"));
+		SetField(result.gender,         data.get("gender"));
+		SetField(result.birthdate,      data.get("birthdate"));
+		SetField(result.birthplace,     data.get("birthplace"));
+		SetField(result.authority,      data.get("authority"));
+		SetField(result.issue_date,     data.get("issue_date"));
+		SetField(result.authority_code, data.get("authority_code"));
+		SetField(result.mrz_line1,      data.get("mrz_line1"));
+		SetField(result.mrz_line2,      data.get("mrz_line2"));
+
+		reporter.SnapshotProcessed(result, data.get("enough_data", false).as_bool(), false);
+	}
+
+	// Plausible, fully populated result that depends only on the key
+	void SyntheticResult(const std::string &key, PassportResultReporterInterface &reporter)
+	{
+		uint64_t hash = StableHash(key);
+
+		PassportMatchResult match;
+		match.score = 0.5 + (hash % 500) / 1000.0;
+		match.type = "rf_passport";
+
+		PassportImageRequest request;
+		reporter.DocumentMatched(match, request);
+
+		char digits[16];
+		PassportRecognitionResult result;
+
+		snprintf(digits, sizeof(digits), "%04u", static_cast<unsigned>(hash % 10000));
+		result.series = PassportStringField(digits);
+		snprintf(digits, sizeof(digits), "%06u", static_cast<unsigned>((hash >> 16) % 1000000));
+		result.number = PassportStringField(digits);
+
+		result.surname = PassportStringField("ИВАНОВ");
+		result.name = PassportStringField("ИВАН");
+		result.patronymic = PassportStringField("ИВАНОВИЧ");
+		result.gender = PassportGenderField(hash & 1 ? PassportGenderField::Male : PassportGenderField::Female);
+		result.birthdate = PassportDateField(1 + hash % 28, 1 + (hash >> 8) % 12, 1950 + (hash >> 12) % 50);
+		result.birthplace = PassportStringField("ГОР. ЕКАТЕРИНБУРГ");
+		result.authority = PassportStringField("ОТДЕЛОМ УФМС РОССИИ ПО СВЕРДЛОВСКОЙ ОБЛ.");
+		result.issue_date = PassportDateField(1 + (hash >> 20) % 28, 1 + (hash >> 28) % 12, 2000 + (hash >> 32) % 16);
+		result.authority_code = PassportCodeField(660, static_cast<int>((hash >> 40) % 1000));
+		result.mrz_line1 = PassportStringField("PNRUSIVANOV<<IVAN<IVANOVICH<<<<<<<<<<<<<<<<<<<");
+		result.mrz_line2 = PassportStringField(std::string(result.series.value) + result.number.value + "<0RUS0000000M0000000<<<<<<<<<<<<<<<0");
+
+		// Acceptance follows the hash bits, so both confidences show up
+		PassportField *fields[] = { &result.series, &result.number, &result.surname, &result.name, &result.patronymic, &result.gender,
+			&result.birthdate, &result.birthplace, &result.authority, &result.issue_date, &result.authority_code, &result.mrz_line1, &result.mrz_line2 };
+		for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); ++i)
+		{
+			fields[i]->is_accepted = ((hash >> i) & 1) != 0;
+		}
+
+		reporter.SnapshotProcessed(result, true, false);
+	}
+
+	void Simulate(const psp::PassportRecognizer &recognizer, const std::string &key)
+	{
+		double jitter = recognizer.latency_jitter_ms * (StableHash(key) % 1000) / 1000.0;
+		double latency = recognizer.latency_ms + jitter;
+
+		Stopwatch stopwatch;
+		BurnCpu(recognizer.cpu_ms);
+		SleepMilliseconds(latency - stopwatch.Stop().wall_ms);
+	}
+
+	PassportResultReporterInterface &SessionReporter(const std::auto_ptr<ProxyResultReporter> &proxy)
+	{
+		if (!proxy.get() || !proxy->reporter)
+		{
+			throw PassportException("Recognition session is not initialized");
+		}
+		return *proxy->reporter;
+	}
+
+	const psp::PassportRecognizer &ConfiguredRecognizer(const std::auto_ptr<psp::PassportRecognizer> &recognizer)
+	{
+		if (!recognizer.get())
+		{
+			throw PassportException("Engine is not configured");
+		}
+		return *recognizer;
+	}
+}
+
+PassportException::PassportException(const std::string &what) : what_(what) {}
+const std::string &PassportException::what() const { return what_; }
+
+PassportPoint::PassportPoint() : x(0), y(0) {}
+PassportPoint::PassportPoint(double x, double y) : x(x), y(y) {}
+
+PassportQuadrangle::PassportQuadrangle() {}
+PassportQuadrangle::PassportQuadrangle(PassportPoint a, PassportPoint b, PassportPoint c, PassportPoint d)
+{
+	points[0] = a;
+	points[1] = b;
+	points[2] = c;
+	points[3] = d;
+}
+PassportPoint &PassportQuadrangle::operator[](int index) { return points[index]; }
+const PassportPoint &PassportQuadrangle::operator[](int index) const { return points[index]; }
+const PassportPoint &PassportQuadrangle::GetPoint(int index) const { return points[index]; }
+void PassportQuadrangle::SetPoint(int index, const PassportPoint &value) { points[index] = value; }
+
+PassportSize::PassportSize() : width(0), height(0) {}
+PassportSize::PassportSize(int width, int height) : width(width), height(height) {}
+
+PassportImage::PassportImage() : data(0), width(0), height(0), stride(0), channels(0) {}
+int PassportImage::GetRequiredBufferLength() const { return stride * height; }
+void PassportImage::CopyToBuffer(char *out_buffer, int buffer_length) const
+{
+	if (buffer_length < GetRequiredBufferLength())
+	{
+		throw PassportException("Buffer is too small");
+	}
+	memcpy(out_buffer, data, GetRequiredBufferLength());
+}
+
+PassportField::PassportField() : is_accepted(false) {}
+PassportField::~PassportField() {}
+
+PassportStringField::PassportStringField() {}
+PassportStringField::PassportStringField(const std::string &value) : value(value) {}
+std::string PassportStringField::ToString() const { return value; }
+
+PassportDateField::PassportDateField() : day(0), month(0), year(0) {}
+PassportDateField::PassportDateField(int day, int month, int year) : day(day), month(month), year(year) {}
+std::string PassportDateField::ToString() const
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%02d.%02d.%04d", day, month, year);
+	return buffer;
+}
+
+PassportGenderField::PassportGenderField() : value(Unknown) {}
+PassportGenderField::PassportGenderField(Gender value) : value(value) {}
+std::string PassportGenderField::ToString() const { return value == Male ? "M" : value == Female ? "F" : ""; }
+
+PassportCodeField::PassportCodeField() : code0(0), code1(0) {}
+PassportCodeField::PassportCodeField(int code0, int code1) : code0(code0), code1(code1) {}
+std::string PassportCodeField::ToString() const
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%03d-%03d", code0, code1);
+	return buffer;
+}
+
+PassportMatchResult::PassportMatchResult() : score(0) {}
+
+void PassportResultReporterInterface::SnapshotRejected() {}
+void PassportResultReporterInterface::DocumentMatched(const PassportMatchResult &, PassportImageRequest &) {}
+void PassportResultReporterInterface::DocumentImageCropped(const PassportImageResult &) {}
+PassportResultReporterInterface::~PassportResultReporterInterface() {}
+
+PassportEngine::PassportEngine()
+	: proxy_reporter_(new ProxyResultReporter())
+{
+}
+
+void PassportEngine::Configure(const std::string &config_path)
+{
+	std::ifstream config_file(config_path);
+	if (!config_file)
+	{
+		throw PassportException("Failed to open config file " + config_path);
+	}
+
+	json config;
+	try {
+		config = json::parse_stream(config_file);
+	}
+	catch (const std::exception &e) {
+		throw PassportException("Failed to parse config file " + config_path + ": " + e.what());
+	}
+
+	std::auto_ptr<psp::PassportRecognizer> recognizer(new psp::PassportRecognizer());
+	if (config.has_member("recorded_results"))
+	{
+		recognizer->recorded_results = CopyString(config["recorded_results"].as_string());
+	}
+	recognizer->latency_ms = config.get("latency_ms", 0.0).as_double();
+	recognizer->latency_jitter_ms = config.get("latency_jitter_ms", 0.0).as_double();
+	recognizer->cpu_ms = config.get("cpu_ms", 0.0).as_double();
+
+	size_t model_size = static_cast<size_t>(config.get("model_mb", 0.0).as_double() * 1024 * 1024);
+	if (model_size > 0)
+	{
+		recognizer->model = new unsigned char[model_size];
+		memset(recognizer->model, 1, model_size);
+	}
+
+	SleepMilliseconds(config.get("configure_ms", 0.0).as_double());
+	passport_recognizer_ = recognizer;
+}
+
+void PassportEngine::InitializeSession(PassportResultReporterInterface &result_reporter)
+{
+	proxy_reporter_->reporter = &result_reporter;
+}
+
+void PassportEngine::TerminateSession()
+{
+	proxy_reporter_->reporter = nullptr;
+}
+
+void PassportEngine::ProcessSnapshot(const PassportImage &image, ImageOrientation image_orientation, const PassportQuadrangle *document_quadrangle)
+{
+	const psp::PassportRecognizer &recognizer = ConfiguredRecognizer(passport_recognizer_);
+	PassportResultReporterInterface &reporter = SessionReporter(proxy_reporter_);
+	if (!image.data || image.width <= 0 || image.height <= 0)
+	{
+		throw PassportException("Invalid image");
+	}
+
+	// Snapshots carry no path to find a recording by
+	std::string key = std::to_string(image.width) + "x" + std::to_string(image.height);
+	Simulate(recognizer, key);
+	SyntheticResult(key, reporter);
+}
+
+void PassportEngine::ProcessSnapshot(unsigned char *data, int width, int height, int stride, int channels, ImageOrientation image_orientation, const PassportQuadrangle *document_quadrangle)
+{
+	PassportImage image;
+	image.data = data;
+	image.width = width;
+	image.height = height;
+	image.stride = stride;
+	image.channels = channels;
+	ProcessSnapshot(image, image_orientation, document_quadrangle);
+}
+
+void PassportEngine::ProcessYUVSnapshot(char *yuv_data, size_t yuv_data_length, int width, int height, ImageOrientation image_orientation, const PassportQuadrangle *document_quadrangle)
+{
+	// Only the luma plane is used for the key; the synthetic result does not depend on pixels
+	if (!yuv_data || yuv_data_length < static_cast<size_t>(width) * height)
+	{
+		throw PassportException("Invalid image");
+	}
+	ProcessSnapshot(reinterpret_cast<unsigned char *>(yuv_data), width, height, width, 1, image_orientation, document_quadrangle);
+}
+
+void PassportEngine::ProcessImageFile(const std::string &image_file, ImageOrientation image_orientation, const PassportQuadrangle *document_quadrangle)
+{
+	const psp::PassportRecognizer &recognizer = ConfiguredRecognizer(passport_recognizer_);
+	PassportResultReporterInterface &reporter = SessionReporter(proxy_reporter_);
+	if (!std::ifstream(image_file))
+	{
+		throw PassportException("Failed to open image file " + image_file);
+	}
+
+	std::string relative_path = RelativeImagePath(image_file);
+	Simulate(recognizer, relative_path);
+
+	if (!recognizer.recorded_results)
+	{
+		SyntheticResult(relative_path, reporter);
+		return;
+	}
+
+	std::string recording_path = std::string(recognizer.recorded_results) + "/" + relative_path + ".json";
+	std::ifstream recording(recording_path);
+	if (!recording)
+	{
+		throw PassportException("No recorded result for " + relative_path);
+	}
+
+	json recorded;
+	try {
+		recorded = json::parse_stream(recording);
+	}
+	catch (const std::exception &e) {
+		throw PassportException("Failed to parse recorded result " + recording_path + ": " + e.what());
+	}
+	ReplayResult(recorded, reporter);
+}
@@ -0,0 +1,259 @@
+// Checks of the number and string fast paths in jsoncons against their
+// reference implementations: shortest float printing against strtod, the
+// exact float parsing fast path against strtod, and the SSE2/AVX2 string
+// scanners against the plain character loops, around every vector boundary.
+// Exits with a non-zero code if any check fails.
+
+#include "jsoncons/json.hpp"
+#include "jsoncons/json_char_scan.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using jsoncons::json;
+
+size_t failures = 0;
+
+void Fail(const std::string &what)
+{
+	if (++failures <= 20)
+	{
+		std::cout << "FAILED: " << what << std::endl;
+	}
+}
+
+uint64_t BitsOf(double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+double DoubleOf(uint64_t bits)
+{
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+std::string ShortestText(double value)
+{
+	return jsoncons::float_to_string<char>(value, 0);
+}
+
+// Precision 0, the output_format default, prints the shortest digits that
+// read back as the same double
+void TestShortestFloat()
+{
+	struct Case
+	{
+		double value;
+		const char *text;
+	};
+	static const Case cases[] =
+	{
+		{ 0.0, "0.0" },
+		{ -0.0, "-0.0" },
+		{ 1.0, "1.0" },
+		{ 0.1, "0.1" },
+		{ 0.001, "0.001" },
+		{ 1e-5, "1.0e-05" },
+		{ 0.30000000000000004, "0.30000000000000004" },
+		{ 123456789012345.0, "123456789012345.0" },
+		{ 1e15, "1.0e+15" },
+		{ 1e21, "1.0e+21" },
+		{ 5e-324, "5.0e-324" },
+		{ 2.2250738585072014e-308, "2.2250738585072014e-308" },
+		{ 1.7976931348623157e308, "1.7976931348623157e+308" }
+	};
+	for (const Case &c : cases)
+	{
+		std::string text = ShortestText(c.value);
+		if (text != c.text)
+		{
+			Fail("float_to_string(" + std::string(c.text) + ", 0) printed " + text);
+		}
+	}
+
+	std::mt19937_64 random(18);
+	for (int i = 0; i < 1000000; ++i)
+	{
+		double value = DoubleOf(random());
+		if (value != value || value - value != 0)
+		{
+			continue;  // NaN and infinities are replaced by the serializer
+		}
+		std::string text = ShortestText(value);
+		if (BitsOf(strtod(text.c_str(), nullptr)) != BitsOf(value))
+		{
+			Fail("round trip of " + text);
+		}
+	}
+}
+
+// The fast path must either decline or give exactly what strtod gives
+void TestFastStringToDouble()
+{
+	struct Case
+	{
+		const char *text;
+		bool fast;
+	};
+	static const Case cases[] =
+	{
+		{ "0", true },
+		{ "0.0", true },
+		{ "123.456e-5", true },
+		{ "9007199254740992", true },    // 2^53
+		{ "9007199254740993", false },   // 2^53 + 1 needs rounding
+		{ "1e22", true },
+		{ "1e23", false },
+		{ "1e-22", true },
+		{ "1e-23", false },
+		{ "12345678901234567", false },  // more than 53 bits
+		{ "1e", false },
+		{ "", false }
+	};
+	for (const Case &c : cases)
+	{
+		double value = 0;
+		bool fast = jsoncons::fast_string_to_double(c.text, strlen(c.text), value);
+		if (fast != c.fast)
+		{
+			Fail(std::string("fast_string_to_double(\"") + c.text + "\") " + (fast ? "accepted" : "declined"));
+		}
+		else if (fast && BitsOf(value) != BitsOf(strtod(c.text, nullptr)))
+		{
+			Fail(std::string("fast_string_to_double(\"") + c.text + "\") differs from strtod");
+		}
+	}
+
+	std::mt19937_64 random(19);
+	for (int i = 0; i < 1000000; ++i)
+	{
+		std::string text = std::to_string(random() % 100000000000000000ULL);
+		int point = static_cast<int>(random() % (text.size() + 1));
+		if (point < static_cast<int>(text.size()))
+		{
+			text.insert(text.begin() + point, '.');
+		}
+		if (random() % 2 == 0)
+		{
+			text += "e" + std::to_string(static_cast<int>(random() % 61) - 30);
+		}
+
+		double value = 0;
+		if (jsoncons::fast_string_to_double(text.c_str(), text.size(), value) &&
+			BitsOf(value) != BitsOf(strtod(text.c_str(), nullptr)))
+		{
+			Fail("fast_string_to_double(\"" + text + "\") differs from strtod");
+		}
+	}
+}
+
+// A special character at every offset of strings a few vectors long, from
+// differently aligned starts
+void TestStringScanners()
+{
+	static const char specials[] = { '\"', '\\', '\x01', '\x1f', '\x7f', '/', '\xc3', ' ', '~' };
+
+	std::vector<char> buffer(128);
+	for (size_t start = 0; start < 4; ++start)
+	{
+		for (size_t length = 0; length <= 70; ++length)
+		{
+			for (size_t position = 0; position <= length; ++position)
+			{
+				for (char special : specials)
+				{
+					memset(buffer.data(), 'a', buffer.size());
+					const char *p = buffer.data() + start;
+					const char *end = p + length;
+					if (position < length)
+					{
+						buffer[start + position] = special;
+					}
+
+					std::string what = "offset " + std::to_string(position) + " of " + std::to_string(length) +
+						", character " + std::to_string(static_cast<unsigned char>(special));
+
+					if (jsoncons::skip_plain_string_chars(p, end) != jsoncons::skip_plain_string_chars<char>(p, end))
+					{
+						Fail("skip_plain_string_chars at " + what);
+					}
+					for (int flags = 0; flags < 4; ++flags)
+					{
+						bool escape_solidus = (flags & 1) != 0;
+						bool escape_non_ascii = (flags & 2) != 0;
+						if (jsoncons::skip_plain_output_chars(p, end, escape_solidus, escape_non_ascii) !=
+							jsoncons::skip_plain_output_chars<char>(p, end, escape_solidus, escape_non_ascii))
+						{
+							Fail("skip_plain_output_chars at " + what);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// Serializing and parsing back a string with an escape at the vector
+	// boundaries gives the same string
+	for (size_t position : { 0, 1, 15, 16, 17, 31, 32, 33, 63, 64 })
+	{
+		for (const char *escaped : { "\"", "\\", "\n", "\x1f", "/" })
+		{
+			std::string value(80, 'x');
+			value.replace(position, 1, escaped);
+
+			json original(value);
+			std::string text = original.to_string();
+			if (json::parse_string(text).as<std::string>() != value)
+			{
+				Fail("string round trip with an escape at offset " + std::to_string(position) + ": " + text);
+			}
+		}
+	}
+}
+
+int main()
+{
+#if defined(JSONCONS_SCAN_AVX2) && defined(__GNUC__)
+	if (!__builtin_cpu_supports("avx2"))
+	{
+		std::cout << "AVX2 is not supported here, skipped" << std::endl;
+		return 0;
+	}
+#endif
+
+	struct Group
+	{
+		const char *name;
+		void (*run)();
+	};
+	static const Group groups[] =
+	{
+		{ "shortest float printing", TestShortestFloat },
+		{ "fast float parsing", TestFastStringToDouble },
+		{ "string scanners", TestStringScanners }
+	};
+
+	int status = 0;
+	for (const Group &group : groups)
+	{
+		failures = 0;
+		group.run();
+		std::cout << (failures == 0 ? "OK      " : "FAILED  ") << group.name;
+		if (failures > 0)
+		{
+			std::cout << " (" << failures << " failures)";
+			status = 1;
+		}
+		std::cout << std::endl;
+	}
+	return status;
+}
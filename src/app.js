@@ -184,6 +184,66 @@ var success = function(entry) {
     return entry;
 };
 
+// Records of a JSON Lines pack file (see SmartEnginesRecognizer --jsonl),
+// located through its index; a later line for the same image wins
+var loadJsonLines = function(path) {
+    if (!fs.existsSync(path) || !fs.existsSync(path + '.idx')) {
+        return null;
+    }
+
+    var records = fs.readFileSync(path);
+    var index = {};
+
+    fs.readFileSync(path + '.idx', 'utf8').split('\n').forEach(function(line) {
+        var fields = line.split('\t');
+        if (fields.length == 3) {
+            index[fields[0]] = [ parseInt(fields[1], 10), parseInt(fields[2], 10) ];
+        }
+    });
+
+    return function(image) {
+        var location = index[image];
+        return location ? JSON.parse(records.toString('utf8', location[0], location[0] + location[1])) : null;
+    };
+};
+
+// Results of every engine and pack, read in one go from the index that
+// ResultIndexer writes (see src/SmartEnginesRecognizer/ResultIndex.h). A pack
+// is not taken from the index once the engine has written results after it
+// was built, to its manifest, pack file or any result file; its result files
+// are read instead.
+var loadResultIndex = function(resultDir) {
+    var indexPath = resultDir + 'index.json';
+    if (!fs.existsSync(indexPath)) {
+        return null;
+    }
+
+    var index = JSON.parse(fs.readFileSync(indexPath, 'utf8'));
+    var indexTime = fs.statSync(indexPath).mtime;
+    var isNewer = function(path) {
+        return fs.existsSync(path) && fs.statSync(path).mtime > indexTime;
+    };
+    var hasNewerResult = function(packPath) {
+        return fs.existsSync(packPath) && fs.readdirSync(packPath).some(function(name) {
+            return /\.json$/.test(name) && isNewer(packPath + '/' + name);
+        });
+    };
+
+    return function(engine, pack) {
+        if (!index[engine] || !index[engine][pack]) {
+            return null;
+        }
+
+        var enginePath = resultDir + engine + '/';
+        if (isNewer(enginePath + 'manifest.txt') || isNewer(enginePath + pack + '.jsonl') ||
+                isNewer(enginePath + pack) || hasNewerResult(enginePath + pack)) {
+            console.warn(indexPath + ' is older than the ' + engine + ' results of ' + pack + ', reading them instead; rerun ResultIndexer');
+            return null;
+        }
+        return index[engine][pack];
+    };
+};
+
 var loadData = function(callback) {
     var data = {
         entries: [],
@@ -215,6 +275,11 @@ var loadData = function(callback) {
         }
     };
 
+    var resultIndex = loadResultIndex(resultPath);
+    var seIndexed = resultIndex && resultIndex('smartengines', 'good');
+    var pvIndexed = resultIndex && resultIndex('passportvision', 'good');
+    var seRecords = seIndexed ? null : loadJsonLines(resultPath + 'smartengines/good.jsonl');
+
     csv.createCsvFileReader(goodCsvPath, {
         'separator': ';',
         'quote': '',
@@ -235,8 +300,18 @@ var loadData = function(callback) {
         var sePath = resultPath + 'smartengines/good/'   + entry.id + '.jpg.json';
         var pvPath = resultPath + 'passportvision/good/' + entry.id + '.jpg.json';
 
-        entry.se = fs.existsSync(sePath) ? JSON.parse(fs.readFileSync(sePath)) : {};
-        entry.pv = fs.existsSync(pvPath) ? JSON.parse(fs.readFileSync(pvPath)) : {};
+        if (seIndexed) {
+            entry.se = seIndexed[entry.id + '.jpg'] || {};
+        } else if (seRecords) {
+            entry.se = seRecords(entry.id + '.jpg') || {};
+        } else {
+            entry.se = fs.existsSync(sePath) ? JSON.parse(fs.readFileSync(sePath)) : {};
+        }
+        if (pvIndexed) {
+            entry.pv = pvIndexed[entry.id + '.jpg'] || {};
+        } else {
+            entry.pv = fs.existsSync(pvPath) ? JSON.parse(fs.readFileSync(pvPath)) : {};
+        }
 
         entry = seRowsCounts(entry);
         entry = pvRowsCounts(entry);